@@ -0,0 +1,740 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "containers/assignment.h"
+#include "containers/batch_fit.h"
+#include "containers/binary.h"
+#include "containers/box.h"
+#include "containers/box_registry.h"
+#include "containers/concurrent_box.h"
+#include "containers/container.h"
+#include "containers/fit_index.h"
+#include "containers/journal.h"
+#include "containers/loader.h"
+#include "containers/parser.h"
+#include "containers/reader.h"
+#include "containers/scanner.h"
+#include "containers/snapshot.h"
+#include "containers/volume_index.h"
+#include "containers/writer.h"
+
+using std::cout;
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void report(const std::string &name, double seconds, double count, const std::string &unit) {
+    cout << name << ": " << count / seconds << ' ' << unit << "/s (" << seconds * 1000 << " ms)\n";
+}
+
+/** Text dump of count boxes in mixed states, one per line */
+std::string makeDump(int count) {
+    std::ostringstream dump;
+    for (int i = 0; i < count; ++i) {
+        Containers::Box b({i % 97 + 10, i % 89 + 10, i % 83 + 10});
+        if (i % 3 != 0) {
+            b.open();
+            b.putItem({i % 7 + 1, i % 5 + 1, i % 9 + 1});
+        }
+        if (i % 3 != 0 && i % 2 == 0) {
+            b.close();
+        }
+        dump << b << '\n';
+    }
+    return dump.str();
+}
+
+void benchParser() {
+    const int count = 200000;
+    const std::string dump = makeDump(count);
+    {
+        std::istringstream ss(dump);
+        Containers::Box b;
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < count; ++i) {
+            ss >> b;
+        }
+        double seconds = secondsSince(start);
+        report("operator>>", seconds, count, "boxes");
+        report("operator>>", seconds, dump.size() / 1e6, "MB");
+    }
+    {
+        Containers::Box b({1, 1, 1});
+        const char *position = dump.data(), *end = dump.data() + dump.size();
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < count; ++i) {
+            Containers::ParseResult r = Containers::parseBox(position, end, b);
+            position += r.position;
+        }
+        double seconds = secondsSince(start);
+        report("parseBox", seconds, count, "boxes");
+        report("parseBox", seconds, dump.size() / 1e6, "MB");
+    }
+}
+
+void benchReader() {
+    const int count = 1000000;
+    const char *path = "bench_dump.txt";
+    {
+        std::ofstream file(path);
+        file << makeDump(count);
+    }
+    for (std::size_t bufferSize = 1 << 12; bufferSize <= 1 << 20; bufferSize <<= 4) {
+        std::ifstream file(path);
+        Containers::BoxReader reader(file, false, bufferSize);
+        Containers::Box b({1, 1, 1});
+        long long read = 0;
+        Clock::time_point start = Clock::now();
+        while (reader.next(b)) {
+            ++read;
+        }
+        double seconds = secondsSince(start);
+        report("BoxReader, " + std::to_string(bufferSize) + " byte buffer", seconds, read, "boxes");
+        report("BoxReader, " + std::to_string(bufferSize) + " byte buffer", seconds, reader.getOffset() / 1e6, "MB");
+    }
+    std::remove(path);
+}
+
+void benchLoader() {
+    const int count = 1000000;
+    const std::string dump = makeDump(count);
+    {
+        std::istringstream ss(dump);
+        std::vector<Containers::Box> boxes(count);
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < count; ++i) {
+            ss >> boxes[i];
+        }
+        report("operator>>", secondsSince(start), dump.size() / 1e6, "MB");
+    }
+    unsigned hardware = std::max(std::thread::hardware_concurrency(), 1u);
+    for (unsigned threads = 1; threads <= 2 * hardware; threads *= 2) {
+        std::vector<Containers::Box> boxes;
+        Clock::time_point start = Clock::now();
+        Containers::loadBoxes(dump.data(), dump.data() + dump.size(), boxes, threads);
+        report("loadBoxes, " + std::to_string(threads) + " threads", secondsSince(start), dump.size() / 1e6, "MB");
+    }
+}
+
+void benchScanner() {
+    const int count = 1000000;
+    const std::string dump = makeDump(count);
+    const char *begin = dump.data(), *end = dump.data() + dump.size();
+    {
+        std::istringstream ss(dump);
+        Containers::Box b;
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < count; ++i) {
+            ss >> b;
+        }
+        report("operator>>", secondsSince(start), dump.size() / 1e9, "GB");
+    }
+    const Containers::ScanLevel levels[] = {Containers::ScanLevel::SCALAR, Containers::ScanLevel::SSE2, Containers::ScanLevel::AVX2};
+    const char *names[] = {"scalar", "SSE2", "AVX2"};
+    std::vector<std::uint32_t> index;
+    for (int l = 0; l < 3; ++l) {
+        if (levels[l] > Containers::detectScanLevel()) {
+            cout << "  " << names[l] << " not supported\n";
+            continue;
+        }
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < 10; ++i) {
+            index.clear();
+            Containers::scanStructure(begin, end, index, levels[l]);
+        }
+        report(std::string("scanStructure, ") + names[l], secondsSince(start) / 10, dump.size() / 1e9, "GB");
+    }
+    std::vector<Containers::BoxValue> boxes;
+    boxes.reserve(count);
+    Clock::time_point start = Clock::now();
+    Containers::parseStructured(begin, end, index, boxes);
+    report("parseStructured", secondsSince(start), dump.size() / 1e9, "GB");
+    boxes.clear();
+    start = Clock::now();
+    Containers::parseBoxes(begin, end, boxes);
+    report("parseBoxes, both stages", secondsSince(start), dump.size() / 1e9, "GB");
+}
+
+void benchSelect() {
+    const int count = 1000000;
+    const std::string dump = makeDump(count);
+    const char *begin = dump.data(), *end = dump.data() + dump.size();
+    {
+        std::vector<Containers::BoxValue> boxes;
+        Clock::time_point start = Clock::now();
+        Containers::loadBoxes(begin, end, boxes, 1);
+        report("loadBoxes, everything", secondsSince(start), dump.size() / 1e6, "MB");
+    }
+    {
+        std::vector<std::uint32_t> index;
+        Clock::time_point start = Clock::now();
+        Containers::scanStructure(begin, end, index);
+        report("scanStructure, raw scan", secondsSince(start), dump.size() / 1e6, "MB");
+    }
+    {
+        std::vector<Containers::BoxFields> boxes;
+        Containers::BoxQuery query(Containers::BoxQuery::SIZE, [](const Containers::BoxFields &b) { return b.hasItem; });
+        Clock::time_point start = Clock::now();
+        Containers::selectBoxes(begin, end, query, boxes, 1);
+        report("selectBoxes, size of full boxes", secondsSince(start), dump.size() / 1e6, "MB");
+        cout << "  selected " << boxes.size() << " boxes\n";
+    }
+    {
+        std::vector<Containers::BoxFields> boxes;
+        Containers::BoxQuery query(Containers::BoxQuery::SIZE, [](const Containers::BoxFields &b) { return b.size.computeVolume() > 500000; });
+        Clock::time_point start = Clock::now();
+        Containers::selectBoxes(begin, end, query, boxes, 1);
+        report("selectBoxes, volume above 500000", secondsSince(start), dump.size() / 1e6, "MB");
+        cout << "  selected " << boxes.size() << " boxes\n";
+    }
+}
+
+void benchValidate() {
+    const int count = 1000000;
+    const std::string dump = makeDump(count);
+    const char *begin = dump.data(), *end = dump.data() + dump.size();
+    unsigned hardware = std::max(std::thread::hardware_concurrency(), 1u);
+    for (unsigned threads = 1; threads <= hardware; threads *= 2) {
+        std::vector<Containers::Box> boxes;
+        Clock::time_point start = Clock::now();
+        Containers::loadBoxes(begin, end, boxes, threads);
+        report("loadBoxes, " + std::to_string(threads) + " threads", secondsSince(start), dump.size() / 1e6, "MB");
+
+        start = Clock::now();
+        Containers::ValidationReport result = Containers::validateBoxes(begin, end, threads);
+        report("validateBoxes, " + std::to_string(threads) + " threads", secondsSince(start), dump.size() / 1e6, "MB");
+        cout << "  " << result.boxes << " valid boxes, " << result.errors.size() << " errors\n";
+    }
+}
+
+void benchJournal() {
+    const int count = 100000;
+    const char *path = "bench_journal.log";
+    std::vector<Containers::Box> boxes;
+    for (int i = 0; i < count; ++i) {
+        boxes.push_back(Containers::Box({i % 100 + 10, 10, 10}));
+    }
+    {
+        std::ostringstream snapshot;
+        Clock::time_point start = Clock::now();
+        Containers::writeBinary(snapshot, boxes.data(), boxes.size());
+        report("writeBinary, full snapshot per change", secondsSince(start), 1, "changes");
+    }
+    struct Policy {
+        const char *name;
+        Containers::JournalOptions options;
+        int operations;
+    };
+    const Policy policies[] = {
+        {"no sync", Containers::JournalOptions(Containers::SyncPolicy::NONE), count},
+        {"periodic sync", Containers::JournalOptions(Containers::SyncPolicy::PERIODIC), count},
+        {"sync per 256 records", Containers::JournalOptions(Containers::SyncPolicy::COMMIT), count},
+        {"sync per record", Containers::JournalOptions(Containers::SyncPolicy::COMMIT, 1), 1000},
+    };
+    for (const Policy &policy : policies) {
+        std::remove(path);
+        Containers::BoxJournal journal(path, policy.options);
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < policy.operations; ++i) {
+            journal.open(boxes[i]);
+        }
+        journal.commit();
+        report(std::string("BoxJournal::open, ") + policy.name, secondsSince(start), policy.operations, "changes");
+        for (int i = 0; i < policy.operations; ++i) {
+            boxes[i].close();
+        }
+    }
+    std::remove(path);
+}
+
+void benchDelta() {
+    const int count = 1000000;
+    Containers::BoxStore store;
+    std::vector<Containers::Box> boxes;
+    for (int i = 0; i < count; ++i) {
+        store.add({i % 100 + 10, 10, 10});
+        boxes.push_back(Containers::Box({i % 100 + 10, 10, 10}));
+    }
+    std::ostringstream full;
+    Clock::time_point start = Clock::now();
+    Containers::writeBinary(full, boxes.data(), boxes.size());
+    report("writeBinary, full checkpoint", secondsSince(start), 1, "checkpoints");
+    store.markClean();
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        boxes[i].markClean();
+    }
+    for (int churn = 100; churn <= count / 10; churn *= 10) {
+        for (int i = 0; i < churn; ++i) {
+            store.open((i * 7919LL) % count);
+            boxes[(i * 7919LL) % count].open();
+        }
+        std::ostringstream storeDelta, boxDelta;
+        start = Clock::now();
+        Containers::writeDelta(storeDelta, store);
+        report("BoxStore delta, " + std::to_string(churn) + " changes", secondsSince(start), 1, "checkpoints");
+        start = Clock::now();
+        Containers::writeDelta(boxDelta, boxes.data(), boxes.size());
+        report("Box delta, " + std::to_string(churn) + " changes", secondsSince(start), 1, "checkpoints");
+        for (int i = 0; i < churn; ++i) {
+            store.close((i * 7919LL) % count);
+            boxes[(i * 7919LL) % count].close();
+        }
+        store.markClean();
+        for (std::size_t i = 0; i < boxes.size(); ++i) {
+            boxes[i].markClean();
+        }
+    }
+}
+
+void benchVolumeIndex() {
+    const int count = 1000000, queries = 100, updates = 1000000;
+    std::vector<Containers::BoxValue> boxes;
+    for (int i = 0; i < count; ++i) {
+        boxes.push_back(Containers::BoxValue({i % 97 + 10, i % 89 + 10, i % 83 + 10}));
+        if (i % 3 == 0) {
+            boxes.back().open();
+            boxes.back().putItem({5, 5, 5});
+        }
+    }
+    Containers::VolumeIndex index;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < count; ++i) {
+        index.insert(boxes[i]);
+    }
+    report("VolumeIndex::insert", secondsSince(start), count, "boxes");
+
+    long long found = 0;
+    start = Clock::now();
+    for (int q = 0; q < queries; ++q) {
+        Containers::Box low({100 + q, 100, 10}), high({100 + q, 100, 20});
+        for (int i = 0; i < count; ++i) {
+            Containers::Box b = boxes[i].toBox();
+            found += low <= b && b <= high;
+        }
+    }
+    report("range count, scan of Box", secondsSince(start), queries, "queries");
+    long long indexed = 0;
+    start = Clock::now();
+    for (int q = 0; q < queries * 10000; ++q) {
+        int l = 100 + q % queries;
+        indexed += index.countInRange(l * 1000LL, l * 2000LL);
+    }
+    report("range count, VolumeIndex", secondsSince(start), queries * 10000, "queries");
+    if (indexed != found * 10000) {
+        std::cout << "mismatch: " << indexed << " != " << found * 10000 << std::endl;
+    }
+
+    std::vector<long long> top;
+    start = Clock::now();
+    for (int q = 0; q < queries; ++q) {
+        std::vector<std::pair<long long, long long> > empty;
+        for (int i = 0; i < count; ++i) {
+            if (!boxes[i].isFull()) {
+                empty.push_back(std::make_pair((long long)boxes[i].getSize().computeVolume(), boxes[i].getId()));
+            }
+        }
+        std::partial_sort(empty.begin(), empty.begin() + 10, empty.end(), std::greater<std::pair<long long, long long> >());
+    }
+    report("top 10 empty, scan", secondsSince(start), queries, "queries");
+    start = Clock::now();
+    for (int q = 0; q < queries * 10000; ++q) {
+        top.clear();
+        index.topK(10, top, true);
+    }
+    report("top 10 empty, VolumeIndex", secondsSince(start), queries * 10000, "queries");
+
+    start = Clock::now();
+    for (int i = 0; i < updates; ++i) {
+        Containers::BoxValue &b = boxes[(i * 7919LL) % count];
+        b.tryOpen();
+        if (b.isFull()) {
+            b.takeItem();
+        } else {
+            b.putItem({5, 5, 5});
+        }
+        index.update(b);
+    }
+    report("VolumeIndex::update", secondsSince(start), updates, "updates");
+}
+
+void benchFitIndex() {
+    const int count = 1000000, scans = 100, queries = 200000;
+    std::vector<Containers::BoxValue> boxes;
+    unsigned state = 1;
+    auto next = [&state](int range) {
+        state = state * 1103515245 + 12345;
+        return (int)((state >> 8) % range) + 10;
+    };
+    for (int i = 0; i < count; ++i) {
+        boxes.push_back(Containers::BoxValue({next(100), next(100), next(100)}));
+    }
+    std::vector<Containers::Dimensions> items;
+    for (int i = 0; i < queries; ++i) {
+        items.push_back(Containers::Dimensions(next(95), next(95), next(95)));
+    }
+
+    Containers::FitIndex index;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < count; ++i) {
+        index.insert(boxes[i]);
+    }
+    report("FitIndex::insert", secondsSince(start), count, "boxes");
+
+    std::vector<long long> scanned(scans, -1);
+    start = Clock::now();
+    for (int q = 0; q < scans; ++q) {
+        const Containers::Dimensions &item = items[q];
+        long long best = -1;
+        for (int i = 0; i < count; ++i) {
+            Containers::Dimensions size = boxes[i].getSize();
+            long long volume = size.computeVolume();
+            if (size.getLength() >= item.getLength() && size.getWidth() >= item.getWidth() && size.getHeight() >= item.getHeight() &&
+                (best < 0 || volume < best)) {
+                best = volume;
+            }
+        }
+        scanned[q] = best;
+    }
+    report("smallest fit, brute-force scan", secondsSince(start), scans, "queries");
+
+    long long id;
+    Containers::Dimensions size;
+    int mismatches = 0;
+    start = Clock::now();
+    for (int q = 0; q < queries; ++q) {
+        bool found = index.findSmallest(items[q], id, size);
+        if (q < scans && (found ? size.computeVolume() : -1) != scanned[q]) {
+            ++mismatches;
+        }
+    }
+    report("smallest fit, FitIndex", secondsSince(start), queries, "queries");
+    if (mismatches != 0) {
+        std::cout << "mismatches: " << mismatches << std::endl;
+    }
+
+    start = Clock::now();
+    int assigned = 0;
+    for (int q = 0; q < queries; ++q) {
+        if (index.findSmallest(items[q], id)) {
+            index.erase(id);
+            ++assigned;
+        }
+    }
+    report("smallest fit and erase", secondsSince(start), assigned, "assignments");
+}
+
+void benchAssignment() {
+    unsigned state = 5;
+    auto next = [&state](int range) {
+        state = state * 1103515245 + 12345;
+        return (int)((state >> 8) % range) + 10;
+    };
+    for (int mode = 0; mode < 2; ++mode) {
+        const int itemCount = mode == 0 ? 200000 : 1500, boxCount = itemCount * 2;
+        std::vector<Containers::Dimensions> items;
+        std::vector<Containers::BoxValue> boxes;
+        long long itemVolume = 0;
+        for (int i = 0; i < itemCount; ++i) {
+            items.push_back(Containers::Dimensions(next(80), next(80), next(80)));
+            itemVolume += items.back().computeVolume();
+        }
+        for (int b = 0; b < boxCount; ++b) {
+            boxes.push_back(Containers::BoxValue({next(90), next(90), next(90)}));
+        }
+        for (unsigned threads = 1; threads <= 4; threads *= 2) {
+            Containers::AssignOptions options(Containers::AssignMode::GREEDY, threads);
+            Clock::time_point start = Clock::now();
+            Containers::Assignment a = Containers::assignItems(items.data(), items.size(), boxes.data(), boxes.size(), options);
+            report("greedy, " + std::to_string(itemCount) + " items, " + std::to_string(threads) + " threads", secondsSince(start), a.matched, "matches");
+            std::cout << "  matched " << a.matched << ", wasted volume " << a.wastedVolume << " (" << 100.0 * a.wastedVolume / itemVolume << "% of items)"
+                      << std::endl;
+        }
+        if (mode == 1) {
+            Clock::time_point start = Clock::now();
+            Containers::Assignment a = Containers::assignItems(items.data(), items.size(), boxes.data(), boxes.size(), {Containers::AssignMode::OPTIMAL});
+            report("optimal, " + std::to_string(itemCount) + " items", secondsSince(start), a.matched, "matches");
+            std::cout << "  matched " << a.matched << ", wasted volume " << a.wastedVolume << " (" << 100.0 * a.wastedVolume / itemVolume << "% of items)"
+                      << std::endl;
+        }
+    }
+}
+
+void benchContainer() {
+    struct Workload {
+        std::string name;
+        Containers::Dimensions size;
+        int count, smallest, range;
+    };
+    const Workload workloads[] = {
+        {"pallet", {1200, 800, 1500}, 2000, 100, 300},
+        {"parcels", {1000, 1000, 1000}, 10000, 30, 60},
+    };
+    for (const Workload &w : workloads) {
+        std::vector<Containers::Dimensions> items;
+        unsigned state = 11;
+        for (int i = 0; i < w.count; ++i) {
+            int sizes[3];
+            for (int axis = 0; axis < 3; ++axis) {
+                state = state * 1103515245 + 12345;
+                sizes[axis] = (state >> 8) % w.range + w.smallest;
+            }
+            items.push_back(Containers::Dimensions(sizes[0], sizes[1], sizes[2]));
+        }
+        for (int variant = 0; variant < 3; ++variant) {
+            bool sorted = variant != 0, rotate = variant == 2;
+            std::string name = w.name + (sorted ? ", sorted batch" : ", arrival order") + (rotate ? ", rotated" : "");
+            Containers::Container container(w.size);
+            Clock::time_point start = Clock::now();
+            if (sorted) {
+                container.insert(items.data(), items.size(), rotate);
+            } else {
+                for (std::size_t i = 0; i < items.size(); ++i) {
+                    container.insert(items[i], rotate);
+                }
+            }
+            double seconds = secondsSince(start);
+            report(name, seconds, container.getItemCount(), "items");
+            std::cout << "  placed " << container.getItemCount() << " of " << items.size() << ", fill ratio " << container.getFillRatio() << std::endl;
+        }
+    }
+}
+
+void benchBatchFit() {
+    const int itemCount = 100000;
+    unsigned state = 17;
+    auto next = [&state](int range) {
+        state = state * 1103515245 + 12345;
+        return (int)((state >> 8) % range) + 10;
+    };
+    std::vector<Containers::Dimensions> items;
+    for (int i = 0; i < itemCount; ++i) {
+        items.push_back(Containers::Dimensions(next(90), next(90), next(90)));
+    }
+    const Containers::ScanLevel levels[] = {Containers::ScanLevel::SCALAR, Containers::ScanLevel::SSE2, Containers::ScanLevel::AVX2};
+    const char *names[] = {"scalar", "SSE2", "AVX2"};
+    for (int catalogSize = 64; catalogSize <= 1024; catalogSize *= 16) {
+        Containers::SizeCatalog catalog;
+        for (int b = 0; b < catalogSize; ++b) {
+            catalog.add(Containers::Dimensions(next(100), next(100), next(100)));
+        }
+        std::vector<std::uint64_t> bits;
+        for (int rotate = 0; rotate < 2; ++rotate) {
+            for (int l = 0; l < 3; ++l) {
+                Clock::time_point start = Clock::now();
+                Containers::fitItems(items.data(), items.size(), catalog, bits, rotate, levels[l]);
+                report(std::string("fitItems, ") + names[l] + ", " + std::to_string(catalogSize) + " boxes" + (rotate ? ", any rotation" : ""), secondsSince(start),
+                       (long long)itemCount * catalogSize, "checks");
+            }
+        }
+    }
+}
+
+void benchWriter() {
+    const int count = 200000;
+    std::vector<Containers::Box> boxes;
+    std::istringstream dump(makeDump(count));
+    for (int i = 0; i < count; ++i) {
+        boxes.emplace_back();
+        dump >> boxes.back();
+    }
+    std::size_t bytes = 0;
+    {
+        std::ostringstream output;
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < count; ++i) {
+            output << boxes[i] << '\n';
+        }
+        report("operator<<", secondsSince(start), count, "boxes");
+        bytes = output.str().size();
+    }
+    {
+        std::string buffer;
+        Clock::time_point start = Clock::now();
+        for (int round = 0; round < 10; ++round) {
+            buffer.clear();
+            for (int i = 0; i < count; ++i) {
+                Containers::appendText(buffer, boxes[i]);
+                buffer += '\n';
+            }
+        }
+        double seconds = secondsSince(start) / 10;
+        report("appendText", seconds, count, "boxes");
+        report("appendText", seconds, bytes / 1e6, "MB");
+    }
+}
+
+void benchBinary() {
+    const int count = 200000;
+    const std::string dump = makeDump(count);
+    std::vector<Containers::Box> boxes;
+    std::istringstream text(dump);
+    for (int i = 0; i < count; ++i) {
+        boxes.emplace_back();
+        text >> boxes.back();
+    }
+    std::stringstream binary;
+    Clock::time_point start = Clock::now();
+    Containers::writeBinary(binary, boxes.data(), boxes.size());
+    report("writeBinary", secondsSince(start), count, "boxes");
+    cout << "  text " << dump.size() << " bytes, binary " << binary.str().size() << " bytes\n";
+
+    std::vector<Containers::Box> restored;
+    start = Clock::now();
+    Containers::readBinary(binary, restored);
+    report("readBinary", secondsSince(start), count, "boxes");
+}
+
+void benchSnapshot() {
+    const int count = 1000000, lookups = 2000000;
+    const char *path = "bench_snapshot.bin";
+    std::vector<Containers::BoxValue> boxes;
+    for (int i = 0; i < count; ++i) {
+        boxes.push_back(Containers::BoxValue((i * 7919LL) % count, {i % 100 + 1, 10, 10}));
+    }
+    Clock::time_point start = Clock::now();
+    Containers::BoxSnapshot::write(path, boxes.data(), boxes.size());
+    report("BoxSnapshot::write", secondsSince(start), count, "boxes");
+
+    start = Clock::now();
+    Containers::BoxSnapshot snapshot(path);
+    report("BoxSnapshot open", secondsSince(start), 1, "snapshots");
+
+    long long volume = 0;
+    Containers::BoxView view;
+    start = Clock::now();
+    for (int i = 0; i < lookups; ++i) {
+        if (snapshot.find((i * 104729LL) % count, view)) {
+            volume += view.getSize().computeVolume();
+        }
+    }
+    report("BoxSnapshot::find", secondsSince(start), lookups, "lookups");
+
+    std::ifstream file(path, std::ios::binary);
+    std::vector<Containers::BoxValue> restored;
+    start = Clock::now();
+    Containers::readBinary(file, restored);
+    report("readBinary, full load", secondsSince(start), count, "boxes");
+    cout << "  checksum " << volume << '\n';
+    std::remove(path);
+}
+
+void benchContendedBox() {
+    const int boxCount = 4, operations = 1000000;
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        std::vector<Containers::ConcurrentBox *> boxes;
+        for (int i = 0; i < boxCount; ++i) {
+            boxes.push_back(new Containers::ConcurrentBox(Containers::Dimensions(10, 10, 10)));
+            boxes.back()->open();
+        }
+        std::atomic<long long> succeeded(0);
+        Clock::time_point start = Clock::now();
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.push_back(std::thread([&boxes, &succeeded, threads] {
+                long long wins = 0;
+                Containers::Dimensions item(1, 1, 1);
+                for (int i = 0; i < operations / threads; ++i) {
+                    Containers::ConcurrentBox &box = *boxes[i % boxCount];
+                    if (box.tryPutItem(item) == Containers::BoxStatus::OK) {
+                        ++wins;
+                    }
+                    if (box.tryTakeItem(item) == Containers::BoxStatus::OK) {
+                        ++wins;
+                    }
+                }
+                succeeded += wins;
+            }));
+        }
+        for (std::size_t t = 0; t < workers.size(); ++t) {
+            workers[t].join();
+        }
+        report("ConcurrentBox put/take, " + std::to_string(threads) + " threads", secondsSince(start), 2.0 * operations, "ops");
+        cout << "  successful transitions: " << succeeded << '\n';
+        for (int i = 0; i < boxCount; ++i) {
+            delete boxes[i];
+        }
+    }
+}
+
+void benchRegistryLookup() {
+    const int boxCount = 100000, lookups = 2000000;
+    Containers::BoxRegistry registry;
+    std::vector<long long> ids;
+    for (int i = 0; i < boxCount; ++i) {
+        Containers::Box b({i % 100 + 1, 10, 10});
+        ids.push_back(b.getId());
+        registry.insert(std::move(b));
+    }
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        std::atomic<long long> found(0);
+        Clock::time_point start = Clock::now();
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.push_back(std::thread([&registry, &ids, &found, threads, t] {
+                Containers::Box b;
+                long long hits = 0;
+                for (int i = t; i < lookups; i += threads) {
+                    hits += registry.find(ids[(i * 7919LL) % boxCount], b);
+                }
+                found += hits;
+            }));
+        }
+        for (std::size_t t = 0; t < workers.size(); ++t) {
+            workers[t].join();
+        }
+        report("BoxRegistry::find, " + std::to_string(threads) + " threads", secondsSince(start), found, "lookups");
+    }
+}
+
+struct Benchmark {
+    const char *name;
+    void (*run)();
+};
+
+const Benchmark BENCHMARKS[] = {
+    {"concurrent_box", benchContendedBox},
+    {"registry", benchRegistryLookup},
+    {"parser", benchParser},
+    {"reader", benchReader},
+    {"loader", benchLoader},
+    {"scanner", benchScanner},
+    {"select", benchSelect},
+    {"validate", benchValidate},
+    {"journal", benchJournal},
+    {"delta", benchDelta},
+    {"volume", benchVolumeIndex},
+    {"fit", benchFitIndex},
+    {"assign", benchAssignment},
+    {"container", benchContainer},
+    {"batchfit", benchBatchFit},
+    {"writer", benchWriter},
+    {"binary", benchBinary},
+    {"snapshot", benchSnapshot},
+};
+
+/** Runs the benchmarks named on the command line, or all of them */
+int main(int argc, char **argv) {
+    for (const Benchmark &b : BENCHMARKS) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; ++i) {
+            selected |= std::strcmp(argv[i], b.name) == 0;
+        }
+        if (selected) {
+            cout << "== " << b.name << " ==\n";
+            b.run();
+            cout << std::endl;
+        }
+    }
+}
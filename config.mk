@@ -1,8 +1,9 @@
 CXX = g++
 RM = rm -f
 LDLIBS = 
-CFLAGS = -Wall -O2 -Wpedantic -std=c++11
+CFLAGS = -Wall -O2 -Wpedantic -std=c++11 -pthread
 TESTS_TARGET = tests
 MAIN_TARGET = main
+BENCH_TARGET = benchmarks
 LOGFILE = test_logs.txt
 DOXYGEN = doxygen
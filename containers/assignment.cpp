@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+#include "assignment.h"
+#include "batch_fit.h"
+#include "fit_index.h"
+#include "internal.h"
+
+namespace Containers {
+
+    const std::size_t Assignment::NONE;
+
+    /** Stripes with fewer items than this are not worth a thread */
+    static const std::size_t MIN_STRIPE_ITEMS = 1024;
+
+    static unsigned threadCount(unsigned threads) {
+        if (threads == 0) {
+            threads = std::thread::hardware_concurrency();
+        }
+        return std::max(threads, 1u);
+    }
+
+    static long long volumeOf(const Dimensions &d) {
+        return (long long)d.getLength() * d.getWidth() * d.getHeight();
+    }
+
+    /** Matches the items, largest first, each to the smallest box left in the index */
+    static void matchGreedy(const Dimensions *items, const std::vector<std::size_t> &order, FitIndex &index, std::vector<std::size_t> &boxOf) {
+        for (std::size_t k = 0; k < order.size(); ++k) {
+            std::size_t item = order[k];
+            long long box;
+            if (index.findSmallest(items[item], box)) {
+                index.erase(box);
+                boxOf[item] = box;
+            }
+        }
+    }
+
+    static void assignGreedy(const Dimensions *items, std::size_t itemCount, const BoxValue *boxes, std::size_t boxCount, unsigned threads,
+                             std::vector<std::size_t> &boxOf) {
+        std::vector<std::size_t> order;
+        for (std::size_t i = 0; i < itemCount; ++i) {
+            if (Rules::isValid(items[i])) {
+                order.push_back(i);
+            }
+        }
+        std::sort(order.begin(), order.end(), [items](std::size_t a, std::size_t b) {
+            long long va = volumeOf(items[a]), vb = volumeOf(items[b]);
+            return va > vb || (va == vb && a < b);
+        });
+
+        std::size_t stripes = std::max<std::size_t>(1, std::min<std::size_t>(threadCount(threads), order.size() / MIN_STRIPE_ITEMS));
+        std::vector<FitIndex> indexes(stripes);
+        std::vector<std::vector<std::size_t> > orders(stripes);
+        for (std::size_t b = 0; b < boxCount; ++b) {
+            if (!boxes[b].isFull()) {
+                indexes[b % stripes].insert(b, boxes[b].getSize());
+            }
+        }
+        for (std::size_t k = 0; k < order.size(); ++k) {
+            orders[k % stripes].push_back(order[k]);
+        }
+        std::vector<std::thread> workers;
+        for (std::size_t s = 1; s < stripes; ++s) {
+            workers.push_back(std::thread([items, &orders, &indexes, &boxOf, s] { matchGreedy(items, orders[s], indexes[s], boxOf); }));
+        }
+        matchGreedy(items, orders[0], indexes[0], boxOf);
+        for (std::size_t t = 0; t < workers.size(); ++t) {
+            workers[t].join();
+        }
+        if (stripes == 1) {
+            return;
+        }
+
+        /* Items a stripe could not place may still fit a box left over in another one */
+        std::vector<std::size_t> left;
+        for (std::size_t k = 0; k < order.size(); ++k) {
+            if (boxOf[order[k]] == Assignment::NONE) {
+                left.push_back(order[k]);
+            }
+        }
+        if (left.empty()) {
+            return;
+        }
+        std::vector<bool> taken(boxCount, false);
+        for (std::size_t i = 0; i < itemCount; ++i) {
+            if (boxOf[i] != Assignment::NONE) {
+                taken[boxOf[i]] = true;
+            }
+        }
+        FitIndex rest;
+        for (std::size_t b = 0; b < boxCount; ++b) {
+            if (!boxes[b].isFull() && !taken[b]) {
+                rest.insert(b, boxes[b].getSize());
+            }
+        }
+        matchGreedy(items, left, rest, boxOf);
+    }
+
+    /** Solves the assignment problem on a rows x cols cost matrix with rows <= cols by the Hungarian method.
+     * @return the column of every row */
+    template <class Cost>
+    static std::vector<std::size_t> hungarian(std::size_t rows, std::size_t cols, Cost cost) {
+        const long long INF = LLONG_MAX / 4;
+        std::vector<long long> u(rows + 1, 0), v(cols + 1, 0), minv(cols + 1);
+        std::vector<std::size_t> p(cols + 1, 0), way(cols + 1, 0);
+        std::vector<bool> used(cols + 1);
+        for (std::size_t i = 1; i <= rows; ++i) {
+            p[0] = i;
+            std::size_t j0 = 0;
+            std::fill(minv.begin(), minv.end(), INF);
+            std::fill(used.begin(), used.end(), false);
+            do {
+                used[j0] = true;
+                std::size_t i0 = p[j0], j1 = 0;
+                long long delta = INF;
+                for (std::size_t j = 1; j <= cols; ++j) {
+                    if (!used[j]) {
+                        long long cur = cost(i0 - 1, j - 1) - u[i0] - v[j];
+                        if (cur < minv[j]) {
+                            minv[j] = cur;
+                            way[j] = j0;
+                        }
+                        if (minv[j] < delta) {
+                            delta = minv[j];
+                            j1 = j;
+                        }
+                    }
+                }
+                for (std::size_t j = 0; j <= cols; ++j) {
+                    if (used[j]) {
+                        u[p[j]] += delta;
+                        v[j] -= delta;
+                    } else {
+                        minv[j] -= delta;
+                    }
+                }
+                j0 = j1;
+            } while (p[j0] != 0);
+            do {
+                std::size_t j1 = way[j0];
+                p[j0] = p[j1];
+                j0 = j1;
+            } while (j0 != 0);
+        }
+        std::vector<std::size_t> columnOf(rows);
+        for (std::size_t j = 1; j <= cols; ++j) {
+            if (p[j] != 0) {
+                columnOf[p[j] - 1] = j - 1;
+            }
+        }
+        return columnOf;
+    }
+
+    static void assignOptimal(const Dimensions *items, std::size_t itemCount, const BoxValue *boxes, std::size_t boxCount,
+                              std::vector<std::size_t> &boxOf) {
+        std::vector<std::size_t> itemIndex, boxIndex;
+        std::vector<Dimensions> valid;
+        std::vector<long long> itemVolumes, boxVolumes;
+        SizeCatalog sizes;
+        long long maxVolume = 0;
+        for (std::size_t i = 0; i < itemCount; ++i) {
+            if (Rules::isValid(items[i])) {
+                itemIndex.push_back(i);
+                valid.push_back(items[i]);
+                itemVolumes.push_back(volumeOf(items[i]));
+            }
+        }
+        for (std::size_t b = 0; b < boxCount; ++b) {
+            if (!boxes[b].isFull()) {
+                boxIndex.push_back(b);
+                sizes.add(boxes[b]);
+                boxVolumes.push_back(volumeOf(boxes[b].getSize()));
+                maxVolume = std::max(maxVolume, boxVolumes.back());
+            }
+        }
+        if (itemIndex.empty() || boxIndex.empty()) {
+            return;
+        }
+        /* The cost of every pair is looked up many times, so which items fit which boxes is worked out up front */
+        std::vector<std::uint64_t> fits;
+        fitItems(valid.data(), valid.size(), sizes, fits);
+        const std::size_t words = sizes.rowWords();
+
+        /* A pair which does not fit costs more than any matching wastes, so the least cost matching leaves as few
+         * items unmatched as possible, and wastes the least volume among those */
+        long long pairs = std::min(itemIndex.size(), boxIndex.size());
+        if (maxVolume > LLONG_MAX / 8 / (pairs + 1) / (pairs + 1)) {
+            throw std::invalid_argument(Errors::Assignment::TOO_LARGE);
+        }
+        const long long NO_FIT = maxVolume * pairs + 1;
+        auto cost = [&fits, words, &itemVolumes, &boxVolumes, NO_FIT](std::size_t i, std::size_t b) {
+            return testFit(fits, words, i, b) ? boxVolumes[b] - itemVolumes[i] : NO_FIT;
+        };
+        if (itemIndex.size() <= boxIndex.size()) {
+            std::vector<std::size_t> columnOf = hungarian(itemIndex.size(), boxIndex.size(), cost);
+            for (std::size_t i = 0; i < columnOf.size(); ++i) {
+                if (cost(i, columnOf[i]) != NO_FIT) {
+                    boxOf[itemIndex[i]] = boxIndex[columnOf[i]];
+                }
+            }
+        } else {
+            std::vector<std::size_t> columnOf = hungarian(boxIndex.size(), itemIndex.size(), [&cost](std::size_t b, std::size_t i) { return cost(i, b); });
+            for (std::size_t b = 0; b < columnOf.size(); ++b) {
+                if (cost(columnOf[b], b) != NO_FIT) {
+                    boxOf[itemIndex[columnOf[b]]] = boxIndex[b];
+                }
+            }
+        }
+    }
+
+    Assignment assignItems(const Dimensions *items, std::size_t itemCount, const BoxValue *boxes, std::size_t boxCount, const AssignOptions &options) {
+        Assignment a;
+        a.boxOf.assign(itemCount, Assignment::NONE);
+        if (options.mode == AssignMode::OPTIMAL) {
+            assignOptimal(items, itemCount, boxes, boxCount, a.boxOf);
+        } else {
+            assignGreedy(items, itemCount, boxes, boxCount, options.threads, a.boxOf);
+        }
+        a.matched = 0;
+        a.wastedVolume = 0;
+        for (std::size_t i = 0; i < itemCount; ++i) {
+            if (a.boxOf[i] != Assignment::NONE) {
+                ++a.matched;
+                a.wastedVolume += volumeOf(boxes[a.boxOf[i]].getSize()) - volumeOf(items[i]);
+            }
+        }
+        return a;
+    }
+
+    Assignment assignItems(const Dimensions *items, std::size_t itemCount, const Box *boxes, std::size_t boxCount, const AssignOptions &options) {
+        std::vector<BoxValue> values;
+        values.reserve(boxCount);
+        for (std::size_t b = 0; b < boxCount; ++b) {
+            values.push_back(BoxValue(boxes[b]));
+        }
+        return assignItems(items, itemCount, values.data(), values.size(), options);
+    }
+
+    template <class B>
+    static void apply(const Assignment &assignment, const Dimensions *items, B *boxes) {
+        std::unordered_set<std::size_t> taken;
+        for (std::size_t i = 0; i < assignment.boxOf.size(); ++i) {
+            if (assignment.boxOf[i] != Assignment::NONE) {
+                if (!Rules::isValid(items[i])) {
+                    Rules::raise(BoxStatus::INVALID_DIMENSIONS);
+                }
+                BoxValue b(boxes[assignment.boxOf[i]]);
+                bool hasItem = b.isFull() || !taken.insert(assignment.boxOf[i]).second;
+                BoxStatus status = Rules::checkPut(true, hasItem, b.getSize(), items[i]);
+                if (status == BoxStatus::OK) {
+                    status = Rules::checkClose(true, true, items[i].getHeight(), b.getSize().getHeight());
+                }
+                Rules::raise(status);
+            }
+        }
+        for (std::size_t i = 0; i < assignment.boxOf.size(); ++i) {
+            if (assignment.boxOf[i] != Assignment::NONE) {
+                B &b = boxes[assignment.boxOf[i]];
+                if (b.isClosed()) {
+                    b.open();
+                }
+                b.putItem(items[i]);
+                b.close();
+            }
+        }
+    }
+
+    void applyAssignment(const Assignment &assignment, const Dimensions *items, BoxValue *boxes) {
+        apply(assignment, items, boxes);
+    }
+
+    void applyAssignment(const Assignment &assignment, const Dimensions *items, Box *boxes) {
+        apply(assignment, items, boxes);
+    }
+}
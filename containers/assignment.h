@@ -0,0 +1,62 @@
+#ifndef ASSIGNMENT_H
+#define ASSIGNMENT_H
+
+#include <cstddef>
+#include <vector>
+
+#include "box.h"
+#include "box_value.h"
+#include "dimensions.h"
+
+namespace Containers {
+
+    enum class AssignMode {
+        /** Best fit decreasing: the largest items first, each into the smallest box it fits, found by a FitIndex
+         * query. Runs in parallel. */
+        GREEDY,
+        /** Matches as many items as possible with the least wasted volume, in O(n^2 m) time for n items and m boxes
+         * or the other way round. Meant for up to a few thousand of them, which items fit which boxes is worked out
+         * up front by fitItems(). */
+        OPTIMAL
+    };
+
+    struct AssignOptions {
+        AssignMode mode;
+        /** Threads of the greedy mode, 0 uses one thread per hardware thread */
+        unsigned threads;
+
+        AssignOptions(AssignMode mode = AssignMode::GREEDY, unsigned threads = 0) : mode(mode), threads(threads) {
+        }
+    };
+
+    /** A matching of items to boxes, returned by assignItems() */
+    struct Assignment {
+        /** Marks an item left without a box */
+        static const std::size_t NONE = (std::size_t)-1;
+
+        /** The index of the box for each item, or NONE */
+        std::vector<std::size_t> boxOf;
+        std::size_t matched;
+        /** The total volume of the matched boxes left unused by their items */
+        long long wastedVolume;
+    };
+
+    /* Match items to empty boxes, each box taking at most one item. An item is only matched to a box it can be
+     * put into and closed with, following Box::putItem and Box::close. Full boxes and items with invalid
+     * dimensions stay unmatched. The greedy mode splits boxes and items into stripes matched on their own
+     * threads, then matches what is left over on one thread, so the result depends on the number of threads.
+     * The optimal mode throws std::invalid_argument if the volumes are too large for its exact costs. */
+    Assignment assignItems(const Dimensions *items, std::size_t itemCount, const BoxValue *boxes, std::size_t boxCount,
+                           const AssignOptions &options = AssignOptions());
+    Assignment assignItems(const Dimensions *items, std::size_t itemCount, const Box *boxes, std::size_t boxCount,
+                           const AssignOptions &options = AssignOptions());
+
+    /* Put every matched item into its box and close it, opening the box first if needed. Every pair is checked
+     * first, so if the boxes changed since they were assigned this throws like Box::putItem or Box::close and
+     * leaves all of them as they were. */
+    void applyAssignment(const Assignment &assignment, const Dimensions *items, BoxValue *boxes);
+    void applyAssignment(const Assignment &assignment, const Dimensions *items, Box *boxes);
+
+}
+
+#endif /* ASSIGNMENT_H */
@@ -0,0 +1,131 @@
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CONTAINERS_X86 1
+#endif
+
+#include "batch_fit.h"
+#include "internal.h"
+
+namespace Containers {
+
+    SizeCatalog::SizeCatalog() {
+    }
+
+    void SizeCatalog::reserve(std::size_t count) {
+        for (int axis = 0; axis < 3; ++axis) {
+            columns[axis].reserve(count);
+            sortedColumns[axis].reserve(count);
+        }
+    }
+
+    std::size_t SizeCatalog::size() const {
+        return columns[0].size();
+    }
+
+    void SizeCatalog::clear() {
+        for (int axis = 0; axis < 3; ++axis) {
+            columns[axis].clear();
+            sortedColumns[axis].clear();
+        }
+    }
+
+    void SizeCatalog::add(const Dimensions &size) {
+        validateDimensions(size);
+        int d[3] = {size.getLength(), size.getWidth(), size.getHeight()};
+        for (int axis = 0; axis < 3; ++axis) {
+            columns[axis].push_back(d[axis]);
+        }
+        std::sort(d, d + 3);
+        for (int axis = 0; axis < 3; ++axis) {
+            sortedColumns[axis].push_back(d[axis]);
+        }
+    }
+
+    void SizeCatalog::add(const BoxValue &b) {
+        add(b.getSize());
+    }
+
+    Dimensions SizeCatalog::get(std::size_t i) const {
+        return Dimensions(columns[0][i], columns[1][i], columns[2][i]);
+    }
+
+    /** Sets the bits of the boxes from..count the item fits into, from a multiple of 64 */
+    static void fitScalar(const int *item, const int *const *boxes, std::size_t from, std::size_t count, std::uint64_t *row) {
+        for (std::size_t b = from; b < count; ++b) {
+            if (item[0] <= boxes[0][b] && item[1] <= boxes[1][b] && item[2] <= boxes[2][b]) {
+                row[b / 64] |= std::uint64_t(1) << (b % 64);
+            }
+        }
+    }
+
+#ifdef CONTAINERS_X86
+    __attribute__((target("sse2"))) static void fitSse2(const int *item, const int *const *boxes, std::size_t count, std::uint64_t *row) {
+        __m128i l = _mm_set1_epi32(item[0]), w = _mm_set1_epi32(item[1]), h = _mm_set1_epi32(item[2]);
+        std::size_t b = 0;
+        for (; count - b >= 64; b += 64) {
+            std::uint64_t word = 0;
+            for (int i = 0; i < 64; i += 4) {
+                __m128i tooLarge = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpgt_epi32(l, _mm_loadu_si128(reinterpret_cast<const __m128i *>(boxes[0] + b + i))),
+                                 _mm_cmpgt_epi32(w, _mm_loadu_si128(reinterpret_cast<const __m128i *>(boxes[1] + b + i)))),
+                    _mm_cmpgt_epi32(h, _mm_loadu_si128(reinterpret_cast<const __m128i *>(boxes[2] + b + i))));
+                word |= std::uint64_t(~_mm_movemask_ps(_mm_castsi128_ps(tooLarge)) & 0xF) << i;
+            }
+            row[b / 64] = word;
+        }
+        fitScalar(item, boxes, b, count, row);
+    }
+
+    __attribute__((target("avx2"))) static void fitAvx2(const int *item, const int *const *boxes, std::size_t count, std::uint64_t *row) {
+        __m256i l = _mm256_set1_epi32(item[0]), w = _mm256_set1_epi32(item[1]), h = _mm256_set1_epi32(item[2]);
+        std::size_t b = 0;
+        for (; count - b >= 64; b += 64) {
+            std::uint64_t word = 0;
+            for (int i = 0; i < 64; i += 8) {
+                __m256i tooLarge = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpgt_epi32(l, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(boxes[0] + b + i))),
+                                    _mm256_cmpgt_epi32(w, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(boxes[1] + b + i)))),
+                    _mm256_cmpgt_epi32(h, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(boxes[2] + b + i))));
+                word |= std::uint64_t(~_mm256_movemask_ps(_mm256_castsi256_ps(tooLarge)) & 0xFF) << i;
+            }
+            row[b / 64] = word;
+        }
+        fitScalar(item, boxes, b, count, row);
+    }
+#endif
+
+    void fitItems(const Dimensions *items, std::size_t count, const SizeCatalog &boxes, std::vector<std::uint64_t> &bits, bool anyRotation,
+                  ScanLevel level) {
+        if (level > detectScanLevel()) {
+            level = detectScanLevel();
+        }
+        const std::vector<int> *columns = anyRotation ? boxes.sortedColumns : boxes.columns;
+        const int *sizes[3] = {columns[0].data(), columns[1].data(), columns[2].data()};
+        const std::size_t words = boxes.rowWords(), boxCount = boxes.size();
+        bits.assign(count * words, 0);
+        for (std::size_t i = 0; i < count; ++i) {
+            if (!Rules::isValid(items[i])) {
+                continue;
+            }
+            int item[3] = {items[i].getLength(), items[i].getWidth(), items[i].getHeight()};
+            if (anyRotation) {
+                std::sort(item, item + 3);
+            }
+            std::uint64_t *row = bits.data() + i * words;
+            switch (level) {
+#ifdef CONTAINERS_X86
+                case ScanLevel::AVX2:
+                    fitAvx2(item, sizes, boxCount, row);
+                    break;
+                case ScanLevel::SSE2:
+                    fitSse2(item, sizes, boxCount, row);
+                    break;
+#endif
+                default:
+                    fitScalar(item, sizes, 0, boxCount, row);
+            }
+        }
+    }
+}
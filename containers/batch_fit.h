@@ -0,0 +1,59 @@
+#ifndef BATCH_FIT_H
+#define BATCH_FIT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "box_value.h"
+#include "dimensions.h"
+#include "scanner.h"
+
+namespace Containers {
+
+    /** Box sizes stored column by column, the layout read by the batch fit kernel. Each size is also kept with
+     * its dimensions sorted, as an item fits some rotation of a box exactly when its sorted dimensions fit the
+     * sorted dimensions of the box. */
+    class SizeCatalog {
+       private:
+        std::vector<int> columns[3];
+        std::vector<int> sortedColumns[3];
+
+        friend void fitItems(const Dimensions *items, std::size_t count, const SizeCatalog &boxes, std::vector<std::uint64_t> &bits, bool anyRotation,
+                             ScanLevel level);
+
+       public:
+        SizeCatalog();
+
+        void reserve(std::size_t count);
+        std::size_t size() const;
+        void clear();
+
+        /** @param size the dimensions, all of them must be positive */
+        void add(const Dimensions &size);
+        void add(const BoxValue &b);
+        Dimensions get(std::size_t i) const;
+
+        /** The number of 64 bit words in the fit bitmap of one item */
+        std::size_t rowWords() const {
+            return (size() + 63) / 64;
+        }
+    };
+
+    /** Checks every item against every box of the catalog at once, setting bit b % 64 of word b / 64 of the row of
+     * an item when it can be put into box b and the box can still be closed, as Box::putItem and Box::close
+     * decide. With anyRotation the item may also be turned into any of its six axis-aligned orientations.
+     * bits is replaced by count rows of rowWords() words, and items with invalid dimensions fit nowhere.
+     * A level the CPU does not support is lowered to one it does. The bitmap takes count * size() bits, so it
+     * serves the optimal assignment, which needs every pair anyway, and not the greedy one, which asks a
+     * FitIndex for one box per item. */
+    void fitItems(const Dimensions *items, std::size_t count, const SizeCatalog &boxes, std::vector<std::uint64_t> &bits, bool anyRotation = false,
+                  ScanLevel level = detectScanLevel());
+
+    inline bool testFit(const std::vector<std::uint64_t> &bits, std::size_t rowWords, std::size_t item, std::size_t box) {
+        return (bits[item * rowWords + box / 64] >> (box % 64)) & 1;
+    }
+
+}
+
+#endif /* BATCH_FIT_H */
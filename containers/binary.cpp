@@ -0,0 +1,260 @@
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "binary.h"
+#include "internal.h"
+
+namespace Containers {
+
+    void Binary::encodeHeader(unsigned char *out, const Header &header) {
+        for (int i = 0; i < 4; ++i) {
+            out[i] = MAGIC[i];
+        }
+        put(out + 4, header.version, 2);
+        put(out + 6, header.flags, 2);
+        put(out + 8, header.count, 8);
+    }
+
+    bool Binary::decodeHeader(const unsigned char *in, Header &header) {
+        for (int i = 0; i < 4; ++i) {
+            if (in[i] != (unsigned char)MAGIC[i]) {
+                return false;
+            }
+        }
+        header.version = get(in + 4, 2);
+        header.flags = get(in + 6, 2);
+        header.count = get(in + 8, 8);
+        return true;
+    }
+
+    void Binary::encodeRecord(unsigned char *out, const BoxValue &b) {
+        Dimensions size = b.getSize(), item = b.isFull() ? b.getItem() : Dimensions();
+        put(out, b.getId(), 8);
+        put(out + 8, (b.isClosed() ? 0 : OPEN) | (b.isFull() ? FULL : 0), 4);
+        put(out + 12, size.getLength(), 4);
+        put(out + 16, size.getWidth(), 4);
+        put(out + 20, size.getHeight(), 4);
+        put(out + 24, item.getLength(), 4);
+        put(out + 28, item.getWidth(), 4);
+        put(out + 32, item.getHeight(), 4);
+        put(out + 36, 0, 4);
+    }
+
+    void Binary::decodeRecord(const unsigned char *in, Serialization::BoxRecord &record) {
+        record.id = get(in, 8);
+        unsigned flags = in[8];
+        record.isOpen = flags & OPEN;
+        record.hasItem = flags & FULL;
+        record.size = Dimensions((int)get(in + 12, 4), (int)get(in + 16, 4), (int)get(in + 20, 4));
+        record.item = Dimensions((int)get(in + 24, 4), (int)get(in + 28, 4), (int)get(in + 32, 4));
+    }
+
+    Binary::Header Binary::readHeader(std::istream &s) {
+        unsigned char bytes[HEADER_SIZE];
+        Header header;
+        if (!s.read(reinterpret_cast<char *>(bytes), HEADER_SIZE)) {
+            throw std::logic_error(Errors::Binary::TRUNCATED);
+        }
+        if (!decodeHeader(bytes, header)) {
+            throw std::logic_error(Errors::Binary::INVALID_HEADER);
+        }
+        if (header.version != VERSION) {
+            throw std::logic_error(Errors::Binary::UNSUPPORTED_VERSION);
+        }
+        return header;
+    }
+
+    /** Records are written and read in chunks of this many */
+    static const std::size_t CHUNK = 1024;
+
+    /** Writes a header followed by the records encoded into next(), CHUNK records at a time */
+    class RecordWriter {
+       private:
+        std::ostream &o;
+        unsigned char buffer[CHUNK * Binary::RECORD_SIZE];
+        std::size_t used;
+
+       public:
+        RecordWriter(std::ostream &o, unsigned flags, unsigned long long count) : o(o), used(0) {
+            Binary::Header header = {Binary::VERSION, flags, count};
+            Binary::encodeHeader(buffer, header);
+            o.write(reinterpret_cast<char *>(buffer), Binary::HEADER_SIZE);
+        }
+
+        ~RecordWriter() {
+            flush();
+        }
+
+        /** Returns the place of the next record */
+        unsigned char *next() {
+            if (used == CHUNK) {
+                flush();
+            }
+            return buffer + used++ * Binary::RECORD_SIZE;
+        }
+
+        void flush() {
+            o.write(reinterpret_cast<char *>(buffer), used * Binary::RECORD_SIZE);
+            used = 0;
+        }
+    };
+
+    template <class T>
+    static void writeRecords(std::ostream &o, const T *boxes, std::size_t count) {
+        RecordWriter writer(o, 0, count);
+        for (std::size_t i = 0; i < count; ++i) {
+            Binary::encodeRecord(writer.next(), BoxValue(boxes[i]));
+        }
+    }
+
+    static void encodeTombstone(unsigned char *out, long long id) {
+        std::memset(out, 0, Binary::RECORD_SIZE);
+        Binary::put(out, id, 8);
+        out[8] = Binary::TOMBSTONE;
+    }
+
+    /** Calls read(record) for each of the count records following the header */
+    template <class Read>
+    static void readRecords(std::istream &s, unsigned long long count, const Read &read) {
+        unsigned char buffer[CHUNK * Binary::RECORD_SIZE];
+        for (unsigned long long i = 0; i < count; i += CHUNK) {
+            std::size_t chunk = count - i < CHUNK ? count - i : CHUNK;
+            if (!s.read(reinterpret_cast<char *>(buffer), chunk * Binary::RECORD_SIZE)) {
+                throw std::logic_error(Errors::Binary::TRUNCATED);
+            }
+            for (std::size_t j = 0; j < chunk; ++j) {
+                read(buffer + j * Binary::RECORD_SIZE);
+            }
+        }
+    }
+
+    static BoxValue decodeBox(const unsigned char *in) {
+        Serialization::BoxRecord record;
+        BoxValue b;
+        Binary::decodeRecord(in, record);
+        Rules::raise(Serialization::buildBox(record, b));
+        return b;
+    }
+
+    void writeBinary(std::ostream &o, const Box *boxes, std::size_t count) {
+        writeRecords(o, boxes, count);
+    }
+
+    void writeBinary(std::ostream &o, const BoxValue *boxes, std::size_t count) {
+        writeRecords(o, boxes, count);
+    }
+
+    void readBinary(std::istream &s, std::vector<BoxValue> &out) {
+        Binary::Header header = Binary::readHeader(s);
+        if (header.flags & Binary::DELTA) {
+            throw std::logic_error(Errors::Binary::IS_DELTA);
+        }
+        std::vector<BoxValue> boxes;
+        readRecords(s, header.count, [&boxes](const unsigned char *record) {
+            boxes.push_back(decodeBox(record));
+        });
+        out.insert(out.end(), boxes.begin(), boxes.end());
+    }
+
+    void readBinary(std::istream &s, std::vector<Box> &out) {
+        std::vector<BoxValue> values;
+        readBinary(s, values);
+        std::vector<Box> boxes;
+        boxes.reserve(values.size());
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            boxes.push_back(values[i].toBox());
+            boxes.back().markClean();
+        }
+        out.reserve(out.size() + boxes.size());
+        for (std::size_t i = 0; i < boxes.size(); ++i) {
+            out.push_back(std::move(boxes[i]));
+        }
+    }
+
+    /* Tombstones come first, so a box may take over the ID another box was renamed away from */
+    std::size_t writeDelta(std::ostream &o, Box *boxes, std::size_t count) {
+        std::size_t tombstones = 0, records = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (boxes[i].isDirty()) {
+                ++records;
+                tombstones += boxes[i].getCheckpointId() != boxes[i].getId();
+            }
+        }
+        {
+            RecordWriter writer(o, Binary::DELTA, tombstones + records);
+            for (std::size_t i = 0; i < count; ++i) {
+                if (boxes[i].isDirty() && boxes[i].getCheckpointId() != boxes[i].getId()) {
+                    encodeTombstone(writer.next(), boxes[i].getCheckpointId());
+                }
+            }
+            for (std::size_t i = 0; i < count; ++i) {
+                if (boxes[i].isDirty()) {
+                    Binary::encodeRecord(writer.next(), BoxValue(boxes[i]));
+                }
+            }
+        }
+        if (o) {
+            for (std::size_t i = 0; i < count; ++i) {
+                boxes[i].markClean();
+            }
+        }
+        return tombstones + records;
+    }
+
+    std::size_t writeDelta(std::ostream &o, BoxStore &store) {
+        std::size_t records = store.countDirty();
+        {
+            RecordWriter writer(o, Binary::DELTA, records);
+            for (BoxStore::Handle h = store.nextDirty(0); h < store.size(); h = store.nextDirty(h + 1)) {
+                Serialization::BoxRecord record = {store.getId(h), !store.isClosed(h), store.isFull(h), store.getSize(h), store.getItem(h)};
+                BoxValue b;
+                Serialization::buildBox(record, b);
+                Binary::encodeRecord(writer.next(), b);
+            }
+        }
+        if (o) {
+            store.markClean();
+        }
+        return records;
+    }
+
+    void mergeSnapshots(std::istream &base, const std::vector<std::istream *> &deltas, std::ostream &out) {
+        std::vector<BoxValue> boxes;
+        readBinary(base, boxes);
+        std::vector<bool> removed(boxes.size());
+        std::unordered_map<long long, std::size_t> positions;
+        for (std::size_t i = 0; i < boxes.size(); ++i) {
+            positions[boxes[i].getId()] = i;
+        }
+        for (std::size_t d = 0; d < deltas.size(); ++d) {
+            Binary::Header header = Binary::readHeader(*deltas[d]);
+            if (!(header.flags & Binary::DELTA)) {
+                throw std::logic_error(Errors::Binary::NOT_DELTA);
+            }
+            readRecords(*deltas[d], header.count, [&](const unsigned char *record) {
+                long long id = Binary::get(record, 8);
+                std::unordered_map<long long, std::size_t>::iterator position = positions.find(id);
+                if (record[8] & Binary::TOMBSTONE) {
+                    if (position != positions.end()) {
+                        removed[position->second] = true;
+                        positions.erase(position);
+                    }
+                } else if (position != positions.end()) {
+                    boxes[position->second] = decodeBox(record);
+                } else {
+                    positions[id] = boxes.size();
+                    boxes.push_back(decodeBox(record));
+                    removed.push_back(false);
+                }
+            });
+        }
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < boxes.size(); ++i) {
+            if (!removed[i]) {
+                boxes[kept++] = boxes[i];
+            }
+        }
+        writeRecords(out, boxes.data(), kept);
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef BINARY_H
+#define BINARY_H
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+#include "box.h"
+#include "box_store.h"
+#include "box_value.h"
+
+namespace Containers {
+
+    /* Binary snapshots of boxes. A snapshot starts with a header holding a magic number, the format version
+     * and the record count, followed by one fixed size little-endian record per box with its ID, flags,
+     * size and item. Reading checks every record against the box rules and gives strong exception safety:
+     * out is only extended once the whole snapshot was read successfully. */
+    void writeBinary(std::ostream &o, const Box *boxes, std::size_t count);
+    void writeBinary(std::ostream &o, const BoxValue *boxes, std::size_t count);
+    void readBinary(std::istream &s, std::vector<Box> &out);
+    void readBinary(std::istream &s, std::vector<BoxValue> &out);
+
+    /* Delta snapshots hold only what changed since the last checkpoint: a record for every dirty box, and a
+     * tombstone for the checkpoint ID of every dirty box whose ID changed. Writing one is a checkpoint, the
+     * boxes are marked clean once the whole delta was written. Boxes read by readBinary() are clean.
+     * A box removed from the collection since the last checkpoint is not seen, so it gets no tombstone.
+     * @return the number of records written */
+    std::size_t writeDelta(std::ostream &o, Box *boxes, std::size_t count);
+    std::size_t writeDelta(std::ostream &o, BoxStore &store);
+
+    /** Applies deltas in order to a base snapshot and writes the result as a new base snapshot.
+     * Boxes changed in place keep their position, renamed and new ones are added at the end.
+     * Throws std::logic_error if the base is a delta or a delta is not one. */
+    void mergeSnapshots(std::istream &base, const std::vector<std::istream *> &deltas, std::ostream &out);
+
+}
+
+#endif /* BINARY_H */
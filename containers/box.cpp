@@ -1,34 +1,63 @@
 #include <sstream>
 #include <stdexcept>
+#include <utility>
 
 #include "box.h"
 #include "internal.h"
+#include "slab.h"
 
 namespace Containers {
 
     using std::string;
 
-    void validateDimensions(Dimensions dimensions);
-    void checkInstance(void *instance, string filename, int line);
+    Box::BoxImpl::CounterShard Box::BoxImpl::instanceCounters[Box::BoxImpl::INSTANCE_SHARDS];
 
-    int Box::BoxImpl::idCounter = 0;
-    int Box::BoxImpl::instanceCounter = 0;
+    Box::BoxImpl::BoxImpl(const Dimensions &size) : BoxImpl(size, 0) {
+        this->ID = this->checkpointId = nextBoxId();
+    }
 
-    Box::BoxImpl::BoxImpl(const Dimensions &size) : ID(this->idCounter) {
+    Box::BoxImpl::BoxImpl(const Dimensions &size, long long id) : ID(id) {
         validateDimensions(size);
         this->size = size;
         this->isOpen = false;
         this->hasItem = false;
-        ++Box::BoxImpl::idCounter;
-        ++Box::BoxImpl::instanceCounter;
+        this->dirty = true;
+        this->checkpointId = id;
+        instanceShard().value.fetch_add(1, std::memory_order_relaxed);
     }
 
-    Box::BoxImpl::BoxImpl(const BoxImpl &b) : ID(b.ID), isOpen(b.isOpen), hasItem(b.hasItem), size(b.size), item(b.item) {
-        ++Box::BoxImpl::instanceCounter;
+    Box::BoxImpl::BoxImpl(const BoxImpl &b)
+        : ID(b.ID), isOpen(b.isOpen), hasItem(b.hasItem), dirty(b.dirty), size(b.size), item(b.item), checkpointId(b.checkpointId) {
+        instanceShard().value.fetch_add(1, std::memory_order_relaxed);
     }
 
     Box::BoxImpl::~BoxImpl() {
-        --Box::BoxImpl::instanceCounter;
+        instanceShard().value.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    long long nextBoxId() {
+        static const long long ID_BLOCK_SIZE = 1024;
+        static std::atomic<long long> idCounter(0);
+        static thread_local long long next = 0, end = 0;
+        if (next == end) {
+            next = idCounter.fetch_add(ID_BLOCK_SIZE, std::memory_order_relaxed);
+            end = next + ID_BLOCK_SIZE;
+        }
+        return next++;
+    }
+
+    Box::BoxImpl::CounterShard &Box::BoxImpl::instanceShard() {
+        static std::atomic<int> threads(0);
+        static thread_local int shard = threads.fetch_add(1, std::memory_order_relaxed) % INSTANCE_SHARDS;
+        return instanceCounters[shard];
+    }
+
+    void *Box::BoxImpl::operator new(std::size_t size) {
+        return SlabAllocator<BoxImpl>::allocate();
+    }
+
+    void Box::BoxImpl::operator delete(void *ptr) {
+        SlabAllocator<BoxImpl>::deallocate(ptr);
     }
 
     Box::Box() {
@@ -39,6 +68,9 @@ namespace Containers {
         impl = new BoxImpl(size);
     }
 
+    Box::Box(BoxImpl *impl) : impl(impl) {
+    }
+
     Box::Box(const Box &b) {
         if (b.impl == NULL) {
             this->impl = NULL;
@@ -47,6 +79,10 @@ namespace Containers {
         }
     }
 
+    Box::Box(Box &&b) noexcept : impl(b.impl) {
+        b.impl = NULL;
+    }
+
     Box::~Box() {
         delete impl;
     }
@@ -55,14 +91,40 @@ namespace Containers {
         if (this == &b) {
             return *this;
         }
-        checkInstance(b.impl, __FILE__, __LINE__);
-        BoxImpl *tmp = new BoxImpl(*b.impl);
-        delete this->impl;
-        this->impl = tmp;
+        CHECK_INSTANCE(b.impl);
+        if (this->impl != NULL) {
+            long long checkpointId = this->impl->checkpointId;
+            *this->impl = *b.impl;
+            this->impl->checkpointId = checkpointId;
+            this->impl->dirty = true;
+        } else {
+            this->impl = new BoxImpl(*b.impl);
+        }
 
         return *this;
     }
 
+    Box &Box::operator=(Box &&b) noexcept {
+        if (this != &b) {
+            if (this->impl != NULL && b.impl != NULL) {
+                b.impl->checkpointId = this->impl->checkpointId;
+                b.impl->dirty = true;
+            }
+            delete this->impl;
+            this->impl = b.impl;
+            b.impl = NULL;
+        }
+        return *this;
+    }
+
+    void Box::swap(Box &b) noexcept {
+        std::swap(this->impl, b.impl);
+    }
+
+    void swap(Box &a, Box &b) noexcept {
+        a.swap(b);
+    }
+
     void Box::init(const Dimensions &size) {
         if (impl != NULL) {
             throw std::logic_error(Errors::Box::WRONG_INITIALIZATION);
@@ -70,100 +132,106 @@ namespace Containers {
         impl = new BoxImpl(size);
     }
 
-    int Box::getId() const {
-        checkInstance(this->impl, __FILE__, __LINE__);
+    long long Box::getId() const {
+        CHECK_INSTANCE(this->impl);
         return this->impl->ID;
     }
 
     void Box::open() {
-        checkInstance(this->impl, __FILE__, __LINE__);
-        if (impl->isOpen) {
-            throw std::logic_error(Errors::Box::ALREADY_OPENED);
-        }
-        impl->isOpen = true;
+        CHECK_INSTANCE(this->impl);
+        Rules::raise(tryOpen());
     }
 
     void Box::close() {
-        checkInstance(this->impl, __FILE__, __LINE__);
-        if (!impl->isOpen) {
-            throw std::logic_error(Errors::Box::ALREADY_CLOSED);
-        }
-        if (impl->hasItem && impl->item.getHeight() > impl->size.getHeight()) {
-            throw std::logic_error(Errors::Box::ITEM_TOO_HIGH_TO_CLOSE);
-        }
-        impl->isOpen = false;
+        CHECK_INSTANCE(this->impl);
+        Rules::raise(tryClose());
     }
 
     bool Box::isFull() const {
-        checkInstance(this->impl, __FILE__, __LINE__);
+        CHECK_INSTANCE(this->impl);
         return impl->hasItem;
     }
 
     bool Box::isClosed() const {
-        checkInstance(this->impl, __FILE__, __LINE__);
+        CHECK_INSTANCE(this->impl);
         return !impl->isOpen;
     }
 
     void Box::putItem(const Dimensions &item) {
-        checkInstance(this->impl, __FILE__, __LINE__);
-        validateDimensions(item);
-        if (!impl->isOpen) {
-            throw std::logic_error(Errors::Box::PUTING_TO_CLOSED);
-        }
-        if (impl->hasItem) {
-            throw std::logic_error(Errors::Box::PUTING_TO_FULL);
-        }
-        if (impl->size.getLength() < item.getLength() || impl->size.getWidth() < item.getWidth()) {
-            throw std::logic_error(Errors::Box::ITEM_DOES_NOT_FIT);
-        }
-        impl->item = item;
-        impl->hasItem = true;
+        CHECK_INSTANCE(this->impl);
+        Rules::raise(tryPutItem(item));
     }
 
     Dimensions Box::takeItem() {
-        checkInstance(this->impl, __FILE__, __LINE__);
-        if (!impl->isOpen) {
-            throw std::logic_error(Errors::Box::TAKING_FROM_CLOSED);
+        CHECK_INSTANCE(this->impl);
+        Dimensions item;
+        Rules::raise(tryTakeItem(item));
+        return item;
+    }
+
+    BoxStatus Box::tryOpen() noexcept {
+        if (impl == NULL) {
+            return BoxStatus::UNINITIALIZED;
         }
-        if (!impl->hasItem) {
-            throw std::logic_error(Errors::Box::TAKING_FROM_EMPTY);
+        BoxStatus status = Rules::checkOpen(impl->isOpen);
+        if (status == BoxStatus::OK) {
+            impl->isOpen = true;
+            impl->dirty = true;
         }
-        impl->hasItem = false;
-        return impl->item;
+        return status;
     }
 
-    string Box::toString() const {
-        checkInstance(this->impl, __FILE__, __LINE__);
-        std::ostringstream output;
-        output << Serialization::BEGIN_MARK;
-
-        output << Serialization::Box::FIELD_ID << Serialization::VALUE_MARK << ' ';
-        output << impl->ID << Serialization::VALUE_SEPARATOR << ' ';
-
-        output << Serialization::Box::FIELD_IS_OPEN << Serialization::VALUE_MARK << ' ';
-        output << (impl->isOpen ? Serialization::TRUE : Serialization::FALSE) << Serialization::VALUE_SEPARATOR << ' ';
+    BoxStatus Box::tryClose() noexcept {
+        if (impl == NULL) {
+            return BoxStatus::UNINITIALIZED;
+        }
+        BoxStatus status = Rules::checkClose(impl->isOpen, impl->hasItem, impl->item.getHeight(), impl->size.getHeight());
+        if (status == BoxStatus::OK) {
+            impl->isOpen = false;
+            impl->dirty = true;
+        }
+        return status;
+    }
 
-        if (impl->hasItem) {
-            output << Serialization::Box::FIELD_ITEM << Serialization::VALUE_MARK << ' ';
-            output << impl->item << Serialization::VALUE_SEPARATOR << ' ';
+    BoxStatus Box::tryPutItem(const Dimensions &item) noexcept {
+        if (impl == NULL) {
+            return BoxStatus::UNINITIALIZED;
+        }
+        BoxStatus status = Rules::checkPut(impl->isOpen, impl->hasItem, impl->size, item);
+        if (status == BoxStatus::OK) {
+            impl->item = item;
+            impl->hasItem = true;
+            impl->dirty = true;
         }
+        return status;
+    }
 
-        output << Serialization::Box::FIELD_SIZE << Serialization::VALUE_MARK << ' ';
-        output << impl->size;
+    BoxStatus Box::tryTakeItem(Dimensions &item) noexcept {
+        if (impl == NULL) {
+            return BoxStatus::UNINITIALIZED;
+        }
+        BoxStatus status = Rules::checkTake(impl->isOpen, impl->hasItem);
+        if (status == BoxStatus::OK) {
+            impl->hasItem = false;
+            impl->dirty = true;
+            item = impl->item;
+        }
+        return status;
+    }
 
-        output << Serialization::END_MARK;
-        return output.str();
+    string Box::toString() const {
+        CHECK_INSTANCE(this->impl);
+        return BoxValue(*this).toString();
     }
 
     std::ostream &operator<<(std::ostream &o, const Box &b) {
-        checkInstance(b.impl, __FILE__, __LINE__);
-        o << b.toString();
-        return o;
+        CHECK_INSTANCE(b.impl);
+        return o << BoxValue(b);
     }
 
     std::istream &operator>>(std::istream &s, Box &b) {
         bool leaveOpen = false, putItem = false;
-        int ID;
+        long long ID;
         Dimensions item, size;
         Serialization::readMark(s, Serialization::BEGIN_MARK);
         std::ios_base::fmtflags flags = s.flags();
@@ -187,7 +255,7 @@ namespace Containers {
         } while (Serialization::readNextSeparator(s));
         s.flags(flags);
         Box tmp(size);
-        tmp.impl->ID = ID;
+        tmp.impl->ID = tmp.impl->checkpointId = ID;
         tmp.open();
         if (putItem) {
             tmp.putItem(item);
@@ -195,25 +263,42 @@ namespace Containers {
         if (!leaveOpen) {
             tmp.close();
         }
-        b = tmp;
+        b = std::move(tmp);
         return s;
     }
 
     Box Box::operator++(int) {
-        checkInstance(this->impl, __FILE__, __LINE__);
+        CHECK_INSTANCE(this->impl);
         Box copy = *this;
-        ++(impl->ID);
+        ++*this;
         return copy;
     }
 
     Box &Box::operator++() {
-        checkInstance(this->impl, __FILE__, __LINE__);
+        CHECK_INSTANCE(this->impl);
         ++(impl->ID);
+        impl->dirty = true;
         return *this;
     }
 
+    bool Box::isDirty() const {
+        CHECK_INSTANCE(this->impl);
+        return impl->dirty;
+    }
+
+    long long Box::getCheckpointId() const {
+        CHECK_INSTANCE(this->impl);
+        return impl->checkpointId;
+    }
+
+    void Box::markClean() {
+        CHECK_INSTANCE(this->impl);
+        impl->dirty = false;
+        impl->checkpointId = impl->ID;
+    }
+
     bool Box::equals(const Box &b) const {
-        checkInstance(this->impl, __FILE__, __LINE__);
+        CHECK_INSTANCE(this->impl);
         bool equal = true;
         equal &= impl->size == b.impl->size;
         equal &= this->isClosed() == b.isClosed();
@@ -226,8 +311,8 @@ namespace Containers {
     }
 
     bool Box::operator==(const Box &b) const {
-        checkInstance(this->impl, __FILE__, __LINE__);
-        checkInstance(b.impl, __FILE__, __LINE__);
+        CHECK_INSTANCE(this->impl);
+        CHECK_INSTANCE(b.impl);
         return impl->size.computeVolume() == b.impl->size.computeVolume();
     }
 
@@ -236,8 +321,8 @@ namespace Containers {
     }
 
     bool Box::operator<(const Box &b) const {
-        checkInstance(this->impl, __FILE__, __LINE__);
-        checkInstance(b.impl, __FILE__, __LINE__);
+        CHECK_INSTANCE(this->impl);
+        CHECK_INSTANCE(b.impl);
         return impl->size.computeVolume() < b.impl->size.computeVolume();
     }
 
@@ -253,8 +338,16 @@ namespace Containers {
         return !(*this < b);
     }
 
-    int Box::getCurrentInstances() {
-        return BoxImpl::instanceCounter;
+    long long Box::getCurrentInstances() {
+        long long instances = 0;
+        for (int i = 0; i < BoxImpl::INSTANCE_SHARDS; ++i) {
+            instances += BoxImpl::instanceCounters[i].value.load(std::memory_order_relaxed);
+        }
+        return instances;
+    }
+
+    AllocationStats Box::getAllocationStats() {
+        return SlabAllocator<BoxImpl>::getStats();
     }
 
     void Serialization::readMark(std::istream &s, char mark) {
@@ -285,17 +378,55 @@ namespace Containers {
         return tmp;
     }
 
+    const string &describe(BoxStatus status) {
+        static const string NONE;
+        switch (status) {
+            case BoxStatus::OK:
+                return NONE;
+            case BoxStatus::UNINITIALIZED:
+                return Errors::UNINITIALIZED_USAGE;
+            case BoxStatus::INVALID_DIMENSIONS:
+                return Errors::Dimensions::INVALID;
+            case BoxStatus::ALREADY_OPENED:
+                return Errors::Box::ALREADY_OPENED;
+            case BoxStatus::ALREADY_CLOSED:
+                return Errors::Box::ALREADY_CLOSED;
+            case BoxStatus::ITEM_TOO_HIGH_TO_CLOSE:
+                return Errors::Box::ITEM_TOO_HIGH_TO_CLOSE;
+            case BoxStatus::PUTING_TO_CLOSED:
+                return Errors::Box::PUTING_TO_CLOSED;
+            case BoxStatus::PUTING_TO_FULL:
+                return Errors::Box::PUTING_TO_FULL;
+            case BoxStatus::ITEM_DOES_NOT_FIT:
+                return Errors::Box::ITEM_DOES_NOT_FIT;
+            case BoxStatus::TAKING_FROM_CLOSED:
+                return Errors::Box::TAKING_FROM_CLOSED;
+            case BoxStatus::TAKING_FROM_EMPTY:
+                return Errors::Box::TAKING_FROM_EMPTY;
+        }
+        return NONE;
+    }
+
+    void Rules::throwStatus(BoxStatus status) {
+        if (status == BoxStatus::INVALID_DIMENSIONS) {
+            throw std::invalid_argument(describe(status));
+        }
+        throw std::logic_error(describe(status));
+    }
+
     void validateDimensions(Dimensions dimensions) {
         if (dimensions.getLength() <= 0 || dimensions.getWidth() <= 0 || dimensions.getHeight() <= 0) {
             throw std::invalid_argument(Errors::Dimensions::INVALID);
         }
     }
 
-    void checkInstance(void *instance, string filename, int line) {
-        if (instance == NULL) {
-            std::ostringstream os;
-            os << Errors::UNINITIALIZED_USAGE << " in " << filename << ":" << line;
-            throw std::logic_error(os.str());
-        }
+    void uninitializedUsage() {
+        throw std::logic_error(Errors::UNINITIALIZED_USAGE);
+    }
+
+    void uninitializedUsage(const char *filename, int line, const char *function) {
+        std::ostringstream os;
+        os << Errors::UNINITIALIZED_USAGE << " in " << filename << ":" << line << " (" << function << ")";
+        throw std::logic_error(os.str());
     }
 }
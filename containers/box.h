@@ -1,18 +1,50 @@
 #ifndef BOX_H
 #define BOX_H
 
+#include <cstddef>
 #include <string>
 
 #include "dimensions.h"
 
 namespace Containers {
 
+    /** Counters describing the memory pool behind Box instances */
+    struct AllocationStats {
+        long long allocations, deallocations;
+        /** Number of bulk transfers from the shared pool into a thread cache */
+        long long refills;
+        std::size_t slabs, blockSize, reservedBytes;
+    };
+
+    /** Outcome of the non-throwing Box operations, each failure matches one of the exceptions they replace */
+    enum class BoxStatus : unsigned char {
+        OK,
+        UNINITIALIZED,
+        INVALID_DIMENSIONS,
+        ALREADY_OPENED,
+        ALREADY_CLOSED,
+        ITEM_TOO_HIGH_TO_CLOSE,
+        PUTING_TO_CLOSED,
+        PUTING_TO_FULL,
+        ITEM_DOES_NOT_FIT,
+        TAKING_FROM_CLOSED,
+        TAKING_FROM_EMPTY
+    };
+
+    /** Returns the message the throwing operations use for the given status (empty for BoxStatus::OK) */
+    const std::string &describe(BoxStatus status);
+
     /** Box is rectangular container that can hold at most one item at a time */
     class Box {
        private:
         class BoxImpl;
         BoxImpl *impl;
 
+        explicit Box(BoxImpl *impl);
+
+        friend class BoxStore;
+        friend class BoxValue;
+
        public:
         /** Lazy initialization of the Box. init must be called before using. */
         Box();
@@ -22,14 +54,23 @@ namespace Containers {
          */
         Box(const Dimensions &size);
         Box(const Box &b);
+
+        /** Takes over the state of b, leaving it uninitialized as if constructed by Box(). */
+        Box(Box &&b) noexcept;
         ~Box();
+
+        /** Copies b into this Box, reusing already owned storage when possible */
         Box &operator=(const Box &b);
+        Box &operator=(Box &&b) noexcept;
+
+        void swap(Box &b) noexcept;
+        friend void swap(Box &a, Box &b) noexcept;
 
         /** Initializes a Box.
          * @see Box(const Dimensions &);
          */
         void init(const Dimensions &size);
-        int getId() const;
+        long long getId() const;
         void open();
         void close();
         bool isFull() const;
@@ -47,6 +88,15 @@ namespace Containers {
          */
         Dimensions takeItem();
 
+        /* Non-throwing variants of the operations above. They neither allocate nor throw and leave
+         * the Box unchanged unless BoxStatus::OK is returned. */
+        BoxStatus tryOpen() noexcept;
+        BoxStatus tryClose() noexcept;
+        BoxStatus tryPutItem(const Dimensions &item) noexcept;
+
+        /** @param item receives the taken item on success */
+        BoxStatus tryTakeItem(Dimensions &item) noexcept;
+
         std::string toString() const;
         friend std::ostream &operator<<(std::ostream &o, const Box &b);
 
@@ -60,6 +110,14 @@ namespace Containers {
         /** Pre increment increments ID of this object and returns this object */
         Box &operator++();
 
+        /* Dirty tracking for delta snapshots, see writeDelta(). A box is dirty from its creation and after every
+         * change of its state or ID, until it is marked clean. */
+        bool isDirty() const;
+
+        /** Returns the ID the box had when it was last marked clean or created. Copy and move assignment keep it. */
+        long long getCheckpointId() const;
+        void markClean();
+
         /** Checks for complete box equality (size, item, is opened/close)..
          * @param b The box to compare with
          * @return whether the Boxes are equal
@@ -74,7 +132,9 @@ namespace Containers {
         bool operator>(const Box &b) const;
         bool operator>=(const Box &b) const;
 
-        static int getCurrentInstances();
+        /** Counts BoxImpl instances alive in all threads */
+        static long long getCurrentInstances();
+        static AllocationStats getAllocationStats();
     };
 
 }
@@ -0,0 +1,76 @@
+#include <utility>
+
+#include "box_registry.h"
+
+namespace Containers {
+
+    /** Mixes the ID bits, so consecutive IDs taken from one thread's block land in different shards */
+    static std::size_t shardIndex(long long id, std::size_t shards) {
+        unsigned long long x = id;
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        return x % shards;
+    }
+
+    BoxRegistry::BoxRegistry() {
+    }
+
+    BoxRegistry::Shard &BoxRegistry::shardOf(long long id) {
+        return shards[shardIndex(id, SHARDS)];
+    }
+
+    const BoxRegistry::Shard &BoxRegistry::shardOf(long long id) const {
+        return shards[shardIndex(id, SHARDS)];
+    }
+
+    bool BoxRegistry::insert(const Box &b) {
+        return insert(Box(b));
+    }
+
+    bool BoxRegistry::insert(Box &&b) {
+        long long id = b.getId();
+        Shard &shard = shardOf(id);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        return shard.boxes.insert(std::make_pair(id, std::move(b))).second;
+    }
+
+    bool BoxRegistry::find(long long id, Box &out) const {
+        const Shard &shard = shardOf(id);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        std::unordered_map<long long, Box>::const_iterator it = shard.boxes.find(id);
+        if (it == shard.boxes.end()) {
+            return false;
+        }
+        out = it->second;
+        return true;
+    }
+
+    bool BoxRegistry::contains(long long id) const {
+        const Shard &shard = shardOf(id);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        return shard.boxes.count(id) != 0;
+    }
+
+    bool BoxRegistry::erase(long long id) {
+        Shard &shard = shardOf(id);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        return shard.boxes.erase(id) != 0;
+    }
+
+    std::size_t BoxRegistry::size() const {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < SHARDS; ++i) {
+            std::lock_guard<std::mutex> guard(shards[i].lock);
+            count += shards[i].boxes.size();
+        }
+        return count;
+    }
+
+    void BoxRegistry::clear() {
+        for (std::size_t i = 0; i < SHARDS; ++i) {
+            std::lock_guard<std::mutex> guard(shards[i].lock);
+            shards[i].boxes.clear();
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef BOX_REGISTRY_H
+#define BOX_REGISTRY_H
+
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+
+#include "box.h"
+
+namespace Containers {
+
+    /** BoxRegistry maps box IDs to boxes and can be used from many threads at once.
+     * The IDs are spread over independently locked shards, so threads working on different boxes
+     * rarely wait for each other. Boxes are keyed by the ID they had when inserted, so callbacks
+     * must not change the ID of a registered box.
+     */
+    class BoxRegistry {
+       private:
+        static const std::size_t SHARDS = 64;
+
+        /** Aligned so the locks of neighbouring shards sit on separate cache lines */
+        struct alignas(64) Shard {
+            mutable std::mutex lock;
+            std::unordered_map<long long, Box> boxes;
+        };
+
+        Shard shards[SHARDS];
+
+        Shard &shardOf(long long id);
+        const Shard &shardOf(long long id) const;
+
+       public:
+        BoxRegistry();
+        BoxRegistry(const BoxRegistry &r) = delete;
+        BoxRegistry &operator=(const BoxRegistry &r) = delete;
+
+        /** Registers a copy of an initialized box under its ID
+         * @return false if a box with the same ID is already registered
+         */
+        bool insert(const Box &b);
+        bool insert(Box &&b);
+
+        /** Copies the box with the given ID into out, reusing its storage
+         * @return false if no box has that ID
+         */
+        bool find(long long id, Box &out) const;
+        bool contains(long long id) const;
+        bool erase(long long id);
+        std::size_t size() const;
+        void clear();
+
+        /** Runs f(Box &) on the box with the given ID while its shard is locked
+         * @return false if no box has that ID
+         */
+        template <class F>
+        bool update(long long id, F f) {
+            Shard &shard = shardOf(id);
+            std::lock_guard<std::mutex> guard(shard.lock);
+            std::unordered_map<long long, Box>::iterator it = shard.boxes.find(id);
+            if (it == shard.boxes.end()) {
+                return false;
+            }
+            f(it->second);
+            return true;
+        }
+
+        /** Calls f(const Box &) for every registered box, locking one shard at a time.
+         * Boxes inserted or erased concurrently may or may not be visited.
+         */
+        template <class F>
+        void forEach(F f) const {
+            for (std::size_t i = 0; i < SHARDS; ++i) {
+                std::lock_guard<std::mutex> guard(shards[i].lock);
+                for (std::unordered_map<long long, Box>::const_iterator it = shards[i].boxes.begin(); it != shards[i].boxes.end(); ++it) {
+                    f(it->second);
+                }
+            }
+        }
+    };
+
+}
+
+#endif /* BOX_REGISTRY_H */
@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "box_store.h"
+#include "internal.h"
+
+namespace Containers {
+
+    BoxStore::BoxStore() {
+    }
+
+    void BoxStore::reserve(std::size_t count) {
+        ids.reserve(count);
+        lengths.reserve(count);
+        widths.reserve(count);
+        heights.reserve(count);
+        itemLengths.reserve(count);
+        itemWidths.reserve(count);
+        itemHeights.reserve(count);
+        openBits.reserve((count + 63) / 64);
+        fullBits.reserve((count + 63) / 64);
+        dirtyBits.reserve((count + 63) / 64);
+    }
+
+    std::size_t BoxStore::size() const {
+        return ids.size();
+    }
+
+    void BoxStore::clear() {
+        ids.clear();
+        lengths.clear();
+        widths.clear();
+        heights.clear();
+        itemLengths.clear();
+        itemWidths.clear();
+        itemHeights.clear();
+        openBits.clear();
+        fullBits.clear();
+        dirtyBits.clear();
+    }
+
+    BoxStore::Handle BoxStore::append(long long id, const Dimensions &size) {
+        Handle h = ids.size();
+        ids.push_back(id);
+        lengths.push_back(size.getLength());
+        widths.push_back(size.getWidth());
+        heights.push_back(size.getHeight());
+        itemLengths.push_back(0);
+        itemWidths.push_back(0);
+        itemHeights.push_back(0);
+        if (h % 64 == 0) {
+            openBits.push_back(0);
+            fullBits.push_back(0);
+            dirtyBits.push_back(0);
+        }
+        setBit(dirtyBits, h, true);
+        return h;
+    }
+
+    BoxStore::Handle BoxStore::add(const Dimensions &size) {
+        validateDimensions(size);
+        return append(nextBoxId(), size);
+    }
+
+    BoxStore::Handle BoxStore::add(const Box &b) {
+        long long id = b.getId();
+        const Box::BoxImpl &impl = *b.impl;
+        Handle h = append(id, impl.size);
+        setBit(openBits, h, impl.isOpen);
+        setBit(fullBits, h, impl.hasItem);
+        itemLengths[h] = impl.item.getLength();
+        itemWidths[h] = impl.item.getWidth();
+        itemHeights[h] = impl.item.getHeight();
+        return h;
+    }
+
+    Box BoxStore::get(Handle h) const {
+        checkHandle(h);
+        Box b(new Box::BoxImpl(getSize(h), ids[h]));
+        b.impl->isOpen = testBit(openBits, h);
+        b.impl->hasItem = testBit(fullBits, h);
+        b.impl->item = Dimensions(itemLengths[h], itemWidths[h], itemHeights[h]);
+        return b;
+    }
+
+    long long BoxStore::getId(Handle h) const {
+        checkHandle(h);
+        return ids[h];
+    }
+
+    Dimensions BoxStore::getSize(Handle h) const {
+        checkHandle(h);
+        return Dimensions(lengths[h], widths[h], heights[h]);
+    }
+
+    bool BoxStore::isFull(Handle h) const {
+        checkHandle(h);
+        return testBit(fullBits, h);
+    }
+
+    bool BoxStore::isClosed(Handle h) const {
+        checkHandle(h);
+        return !testBit(openBits, h);
+    }
+
+    Dimensions BoxStore::getItem(Handle h) const {
+        checkHandle(h);
+        return Dimensions(itemLengths[h], itemWidths[h], itemHeights[h]);
+    }
+
+    void BoxStore::open(Handle h) {
+        checkHandle(h);
+        Rules::raise(tryOpen(h));
+    }
+
+    void BoxStore::close(Handle h) {
+        checkHandle(h);
+        Rules::raise(tryClose(h));
+    }
+
+    void BoxStore::putItem(Handle h, const Dimensions &item) {
+        checkHandle(h);
+        Rules::raise(tryPutItem(h, item));
+    }
+
+    Dimensions BoxStore::takeItem(Handle h) {
+        checkHandle(h);
+        Dimensions item;
+        Rules::raise(tryTakeItem(h, item));
+        return item;
+    }
+
+    BoxStatus BoxStore::tryOpen(Handle h) noexcept {
+        if (h >= ids.size()) {
+            return BoxStatus::UNINITIALIZED;
+        }
+        BoxStatus status = Rules::checkOpen(testBit(openBits, h));
+        if (status == BoxStatus::OK) {
+            setBit(openBits, h, true);
+            setBit(dirtyBits, h, true);
+        }
+        return status;
+    }
+
+    BoxStatus BoxStore::tryClose(Handle h) noexcept {
+        if (h >= ids.size()) {
+            return BoxStatus::UNINITIALIZED;
+        }
+        BoxStatus status = Rules::checkClose(testBit(openBits, h), testBit(fullBits, h), itemHeights[h], heights[h]);
+        if (status == BoxStatus::OK) {
+            setBit(openBits, h, false);
+            setBit(dirtyBits, h, true);
+        }
+        return status;
+    }
+
+    BoxStatus BoxStore::tryPutItem(Handle h, const Dimensions &item) noexcept {
+        if (h >= ids.size()) {
+            return BoxStatus::UNINITIALIZED;
+        }
+        BoxStatus status = Rules::checkPut(testBit(openBits, h), testBit(fullBits, h), lengths[h], widths[h], item);
+        if (status == BoxStatus::OK) {
+            itemLengths[h] = item.getLength();
+            itemWidths[h] = item.getWidth();
+            itemHeights[h] = item.getHeight();
+            setBit(fullBits, h, true);
+            setBit(dirtyBits, h, true);
+        }
+        return status;
+    }
+
+    BoxStatus BoxStore::tryTakeItem(Handle h, Dimensions &item) noexcept {
+        if (h >= ids.size()) {
+            return BoxStatus::UNINITIALIZED;
+        }
+        BoxStatus status = Rules::checkTake(testBit(openBits, h), testBit(fullBits, h));
+        if (status == BoxStatus::OK) {
+            setBit(fullBits, h, false);
+            setBit(dirtyBits, h, true);
+            item = Dimensions(itemLengths[h], itemWidths[h], itemHeights[h]);
+        }
+        return status;
+    }
+
+    std::size_t BoxStore::countFull() const {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < fullBits.size(); ++i) {
+            count += __builtin_popcountll(fullBits[i]);
+        }
+        return count;
+    }
+
+    std::size_t BoxStore::countOpen() const {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < openBits.size(); ++i) {
+            count += __builtin_popcountll(openBits[i]);
+        }
+        return count;
+    }
+
+    long long BoxStore::totalVolume() const {
+        long long volume = 0;
+        const std::size_t count = ids.size();
+        for (std::size_t i = 0; i < count; ++i) {
+            volume += (long long)lengths[i] * widths[i] * heights[i];
+        }
+        return volume;
+    }
+
+    bool BoxStore::isDirty(Handle h) const {
+        checkHandle(h);
+        return testBit(dirtyBits, h);
+    }
+
+    std::size_t BoxStore::countDirty() const {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < dirtyBits.size(); ++i) {
+            count += __builtin_popcountll(dirtyBits[i]);
+        }
+        return count;
+    }
+
+    BoxStore::Handle BoxStore::nextDirty(Handle h) const {
+        if (h >= ids.size()) {
+            return ids.size();
+        }
+        std::size_t word = h / 64;
+        std::uint64_t bits = dirtyBits[word] & (~std::uint64_t(0) << (h % 64));
+        while (bits == 0) {
+            if (++word == dirtyBits.size()) {
+                return ids.size();
+            }
+            bits = dirtyBits[word];
+        }
+        return word * 64 + __builtin_ctzll(bits);
+    }
+
+    void BoxStore::markClean() {
+        std::fill(dirtyBits.begin(), dirtyBits.end(), 0);
+    }
+
+    void BoxStore::checkHandle(Handle h) const {
+        if (h >= ids.size()) {
+            throw std::out_of_range(Errors::BoxStore::INVALID_HANDLE);
+        }
+    }
+
+    bool BoxStore::testBit(const std::vector<std::uint64_t> &bits, Handle h) {
+        return (bits[h / 64] >> (h % 64)) & 1;
+    }
+
+    void BoxStore::setBit(std::vector<std::uint64_t> &bits, Handle h, bool value) {
+        if (value) {
+            bits[h / 64] |= std::uint64_t(1) << (h % 64);
+        } else {
+            bits[h / 64] &= ~(std::uint64_t(1) << (h % 64));
+        }
+    }
+}
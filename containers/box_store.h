@@ -0,0 +1,89 @@
+#ifndef BOX_STORE_H
+#define BOX_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "box.h"
+#include "dimensions.h"
+
+namespace Containers {
+
+    /** BoxStore keeps many boxes column by column instead of one heap object per box.
+     * Boxes are addressed by handles returned from add(), which stay valid for the lifetime of the store.
+     * All operations follow the same rules and throw the same exceptions as the ones of Box.
+     */
+    class BoxStore {
+       public:
+        typedef std::size_t Handle;
+
+       private:
+        std::vector<long long> ids;
+        std::vector<int> lengths, widths, heights;
+        std::vector<int> itemLengths, itemWidths, itemHeights;
+        std::vector<std::uint64_t> openBits, fullBits, dirtyBits;
+
+        Handle append(long long id, const Dimensions &size);
+        void checkHandle(Handle h) const;
+        static bool testBit(const std::vector<std::uint64_t> &bits, Handle h);
+        static void setBit(std::vector<std::uint64_t> &bits, Handle h, bool value);
+
+       public:
+        BoxStore();
+
+        void reserve(std::size_t count);
+        std::size_t size() const;
+        void clear();
+
+        /** Adds a new closed empty box, numbered the same way as Box(const Dimensions &)
+         * @param size the dimensions, all of them must be positive
+         */
+        Handle add(const Dimensions &size);
+
+        /** Adds a copy of an initialized Box, keeping its ID and state */
+        Handle add(const Box &b);
+
+        /** Materializes the stored box as a standalone Box */
+        Box get(Handle h) const;
+
+        long long getId(Handle h) const;
+        Dimensions getSize(Handle h) const;
+        bool isFull(Handle h) const;
+        bool isClosed(Handle h) const;
+
+        /** Returns the item inside, only meaningful when isFull(h) */
+        Dimensions getItem(Handle h) const;
+
+        void open(Handle h);
+        void close(Handle h);
+
+        /** @see Box::putItem */
+        void putItem(Handle h, const Dimensions &item);
+
+        /** @see Box::takeItem */
+        Dimensions takeItem(Handle h);
+
+        /* Non-throwing variants, an invalid handle is reported as BoxStatus::UNINITIALIZED. @see Box::tryOpen */
+        BoxStatus tryOpen(Handle h) noexcept;
+        BoxStatus tryClose(Handle h) noexcept;
+        BoxStatus tryPutItem(Handle h, const Dimensions &item) noexcept;
+        BoxStatus tryTakeItem(Handle h, Dimensions &item) noexcept;
+
+        /* Whole store scans, touching only the needed columns. */
+        std::size_t countFull() const;
+        std::size_t countOpen() const;
+        long long totalVolume() const;
+
+        /* Dirty tracking for delta snapshots, like the one of Box. Added boxes are dirty. */
+        bool isDirty(Handle h) const;
+        std::size_t countDirty() const;
+
+        /** Returns the first dirty handle at or after h, or size() if there is none */
+        Handle nextDirty(Handle h) const;
+        void markClean();
+    };
+
+}
+
+#endif /* BOX_STORE_H */
@@ -0,0 +1,153 @@
+#include <stdexcept>
+#include <type_traits>
+
+#include "box_value.h"
+#include "internal.h"
+
+namespace Containers {
+
+    static_assert(std::is_trivially_copyable<BoxValue>::value, "BoxValue must stay trivially copyable");
+
+    BoxValue::BoxValue() : ID(0), isOpen(false), hasItem(false) {
+    }
+
+    BoxValue::BoxValue(const Dimensions &size) : isOpen(false), hasItem(false) {
+        validateDimensions(size);
+        this->size = size;
+        this->ID = nextBoxId();
+    }
+
+    BoxValue::BoxValue(long long id, const Dimensions &size) : ID(id), isOpen(false), hasItem(false) {
+        validateDimensions(size);
+        this->size = size;
+    }
+
+    BoxValue::BoxValue(const Box &b) {
+        this->ID = b.getId();
+        this->isOpen = b.impl->isOpen;
+        this->hasItem = b.impl->hasItem;
+        this->size = b.impl->size;
+        this->item = b.impl->item;
+    }
+
+    Box BoxValue::toBox() const {
+        Box b;
+        assignTo(b);
+        return b;
+    }
+
+    void BoxValue::assignTo(Box &b) const {
+        validateDimensions(size);
+        if (b.impl == NULL) {
+            b.impl = new Box::BoxImpl(size, ID);
+        } else {
+            b.impl->ID = ID;
+            b.impl->size = size;
+        }
+        b.impl->isOpen = isOpen;
+        b.impl->hasItem = hasItem;
+        b.impl->item = item;
+        b.impl->dirty = true;
+    }
+
+    long long BoxValue::getId() const {
+        return ID;
+    }
+
+    Dimensions BoxValue::getSize() const {
+        return size;
+    }
+
+    Dimensions BoxValue::getItem() const {
+        return item;
+    }
+
+    void BoxValue::open() {
+        Rules::raise(tryOpen());
+    }
+
+    void BoxValue::close() {
+        Rules::raise(tryClose());
+    }
+
+    bool BoxValue::isFull() const {
+        return hasItem;
+    }
+
+    bool BoxValue::isClosed() const {
+        return !isOpen;
+    }
+
+    void BoxValue::putItem(const Dimensions &item) {
+        Rules::raise(tryPutItem(item));
+    }
+
+    Dimensions BoxValue::takeItem() {
+        Dimensions item;
+        Rules::raise(tryTakeItem(item));
+        return item;
+    }
+
+    BoxStatus BoxValue::tryOpen() noexcept {
+        BoxStatus status = Rules::checkOpen(isOpen);
+        if (status == BoxStatus::OK) {
+            isOpen = true;
+        }
+        return status;
+    }
+
+    BoxStatus BoxValue::tryClose() noexcept {
+        BoxStatus status = Rules::checkClose(isOpen, hasItem, item.getHeight(), size.getHeight());
+        if (status == BoxStatus::OK) {
+            isOpen = false;
+        }
+        return status;
+    }
+
+    BoxStatus BoxValue::tryPutItem(const Dimensions &item) noexcept {
+        BoxStatus status = Rules::checkPut(isOpen, hasItem, size, item);
+        if (status == BoxStatus::OK) {
+            this->item = item;
+            hasItem = true;
+        }
+        return status;
+    }
+
+    BoxStatus BoxValue::tryTakeItem(Dimensions &item) noexcept {
+        BoxStatus status = Rules::checkTake(isOpen, hasItem);
+        if (status == BoxStatus::OK) {
+            hasItem = false;
+            item = this->item;
+        }
+        return status;
+    }
+
+    char *BoxValue::format(char *out) const {
+        return Serialization::formatBox(out, ID, isOpen, hasItem ? &item : NULL, size);
+    }
+
+    std::string BoxValue::toString() const {
+        char text[Serialization::MAX_BOX_TEXT];
+        return std::string(text, format(text));
+    }
+
+    std::ostream &operator<<(std::ostream &o, const BoxValue &b) {
+        char text[Serialization::MAX_BOX_TEXT];
+        return Serialization::writeText(o, text, b.format(text) - text);
+    }
+
+    std::istream &operator>>(std::istream &s, BoxValue &b) {
+        Box tmp;
+        s >> tmp;
+        b = BoxValue(tmp);
+        return s;
+    }
+
+    bool BoxValue::equals(const BoxValue &b) const {
+        bool equal = size == b.size && isOpen == b.isOpen && hasItem == b.hasItem && ID == b.ID;
+        if (hasItem && b.hasItem) {
+            equal &= item == b.item;
+        }
+        return equal;
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef BOX_VALUE_H
+#define BOX_VALUE_H
+
+#include <string>
+
+#include "box.h"
+#include "dimensions.h"
+
+namespace Containers {
+
+    /** BoxValue is a Box stored inline, without a separately allocated implementation.
+     * It is trivially copyable, so arrays of them can be copied with memcpy. Operations follow the same rules
+     * and throw the same exceptions as the ones of Box. A default constructed BoxValue is empty and closed,
+     * with zero size and ID.
+     */
+    class BoxValue {
+       private:
+        long long ID;
+        bool isOpen, hasItem;
+        Dimensions size, item;
+
+        /** Writes the toString() format to out, which must hold Serialization::MAX_BOX_TEXT characters */
+        char *format(char *out) const;
+
+        friend class ConcurrentBox;
+        friend void appendText(std::string &buffer, const BoxValue &b);
+
+       public:
+        /** Constructs a BoxValue without a size, to be assigned or read into. toBox() and assignTo() reject it. */
+        BoxValue();
+
+        /** Constructs a BoxValue using given dimensions, numbered the same way as Box(const Dimensions &)
+         * @param size the dimensions, all of them must be positive
+         */
+        explicit BoxValue(const Dimensions &size);
+
+        /** Constructs a closed empty BoxValue with the given ID, without consuming one from the counter
+         * @param size the dimensions, all of them must be positive
+         */
+        BoxValue(long long id, const Dimensions &size);
+
+        /** Copies the state of an initialized Box, including its ID */
+        explicit BoxValue(const Box &b);
+
+        /** Creates a standalone Box with the same state and ID */
+        Box toBox() const;
+
+        /** Overwrites b with the same state and ID, reusing its storage if it is initialized. Throws
+         * std::invalid_argument, leaving b unchanged, if the size is not valid. */
+        void assignTo(Box &b) const;
+
+        long long getId() const;
+        Dimensions getSize() const;
+
+        /** Returns the item inside, only meaningful when isFull() */
+        Dimensions getItem() const;
+        void open();
+        void close();
+        bool isFull() const;
+        bool isClosed() const;
+
+        /** @see Box::putItem */
+        void putItem(const Dimensions &item);
+
+        /** @see Box::takeItem */
+        Dimensions takeItem();
+
+        /* @see Box::tryOpen */
+        BoxStatus tryOpen() noexcept;
+        BoxStatus tryClose() noexcept;
+        BoxStatus tryPutItem(const Dimensions &item) noexcept;
+        BoxStatus tryTakeItem(Dimensions &item) noexcept;
+
+        std::string toString() const;
+        friend std::ostream &operator<<(std::ostream &o, const BoxValue &b);
+
+        /** Reads BoxValue from stream, using the toString() format. @see operator>>(std::istream &, Box &) */
+        friend std::istream &operator>>(std::istream &s, BoxValue &b);
+
+        /** Checks for complete equality, just like Box::equals */
+        bool equals(const BoxValue &b) const;
+    };
+
+}
+
+#endif /* BOX_VALUE_H */
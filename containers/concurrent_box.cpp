@@ -0,0 +1,155 @@
+#include <thread>
+
+#include "concurrent_box.h"
+#include "internal.h"
+
+namespace Containers {
+
+    ConcurrentBox::ConcurrentBox(const Dimensions &size) : ID((validateDimensions(size), nextBoxId())), size(size), state(0) {
+        storeItem(Dimensions());
+    }
+
+    ConcurrentBox::ConcurrentBox(const BoxValue &b) : ID(b.ID), size(b.size), state((b.isOpen ? OPEN : 0) | (b.hasItem ? FULL : 0)) {
+        storeItem(b.item);
+    }
+
+    std::uint64_t ConcurrentBox::advance(std::uint64_t previous, std::uint64_t flags) {
+        return ((previous & ~FLAGS) + VERSION) | flags;
+    }
+
+    std::uint64_t ConcurrentBox::stableState() const {
+        std::uint64_t s = state.load(std::memory_order_acquire);
+        while (s & BUSY) {
+            std::this_thread::yield();
+            s = state.load(std::memory_order_acquire);
+        }
+        return s;
+    }
+
+    Dimensions ConcurrentBox::loadItem() const {
+        return Dimensions(itemLength.load(std::memory_order_relaxed), itemWidth.load(std::memory_order_relaxed),
+                          itemHeight.load(std::memory_order_relaxed));
+    }
+
+    void ConcurrentBox::storeItem(const Dimensions &item) {
+        itemLength.store(item.getLength(), std::memory_order_relaxed);
+        itemWidth.store(item.getWidth(), std::memory_order_relaxed);
+        itemHeight.store(item.getHeight(), std::memory_order_relaxed);
+    }
+
+    BoxValue ConcurrentBox::load() const {
+        BoxValue b;
+        b.ID = ID;
+        b.size = size;
+        std::uint64_t s;
+        do {
+            s = stableState();
+            b.item = loadItem();
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while (state.load(std::memory_order_relaxed) != s);
+        b.isOpen = s & OPEN;
+        b.hasItem = s & FULL;
+        return b;
+    }
+
+    long long ConcurrentBox::getId() const {
+        return ID;
+    }
+
+    Dimensions ConcurrentBox::getSize() const {
+        return size;
+    }
+
+    bool ConcurrentBox::isFull() const {
+        return stableState() & FULL;
+    }
+
+    bool ConcurrentBox::isClosed() const {
+        return !(state.load(std::memory_order_acquire) & OPEN);
+    }
+
+    void ConcurrentBox::open() {
+        Rules::raise(tryOpen());
+    }
+
+    void ConcurrentBox::close() {
+        Rules::raise(tryClose());
+    }
+
+    void ConcurrentBox::putItem(const Dimensions &item) {
+        Rules::raise(tryPutItem(item));
+    }
+
+    Dimensions ConcurrentBox::takeItem() {
+        Dimensions item;
+        Rules::raise(tryTakeItem(item));
+        return item;
+    }
+
+    BoxStatus ConcurrentBox::tryOpen() noexcept {
+        std::uint64_t s = state.load(std::memory_order_relaxed);
+        BoxStatus status;
+        do {
+            status = Rules::checkOpen(s & OPEN);
+            if (status != BoxStatus::OK) {
+                return status;
+            }
+        } while (!state.compare_exchange_weak(s, advance(s, (s & FLAGS) | OPEN), std::memory_order_acq_rel, std::memory_order_relaxed));
+        return status;
+    }
+
+    BoxStatus ConcurrentBox::tryClose() noexcept {
+        std::uint64_t s = stableState();
+        BoxStatus status;
+        do {
+            if (s & BUSY) {
+                s = stableState();
+            }
+            int height = (s & FULL) ? itemHeight.load(std::memory_order_relaxed) : 0;
+            status = Rules::checkClose(s & OPEN, s & FULL, height, size.getHeight());
+            if (status != BoxStatus::OK) {
+                return status;
+            }
+        } while (!state.compare_exchange_weak(s, advance(s, s & FULL), std::memory_order_acq_rel, std::memory_order_acquire));
+        return status;
+    }
+
+    BoxStatus ConcurrentBox::tryPutItem(const Dimensions &item) noexcept {
+        std::uint64_t s = state.load(std::memory_order_relaxed);
+        BoxStatus status;
+        do {
+            status = Rules::checkPut(s & OPEN, s & (FULL | BUSY), size, item);
+            if (status != BoxStatus::OK) {
+                return status;
+            }
+        } while (!state.compare_exchange_weak(s, advance(s, OPEN | BUSY), std::memory_order_acquire, std::memory_order_relaxed));
+        /* The seqlock writer side: without this fence the relaxed item stores may become visible before the new
+         * version, and load() would accept the new item under the old one. x86 never reorders stores, so only
+         * weakly ordered CPUs such as ARM could show it, which the #CONCURRENT test does not run on. */
+        std::atomic_thread_fence(std::memory_order_release);
+        storeItem(item);
+        state.store(advance(s + VERSION, OPEN | FULL), std::memory_order_release);
+        return status;
+    }
+
+    BoxStatus ConcurrentBox::tryTakeItem(Dimensions &item) noexcept {
+        std::uint64_t s = stableState();
+        BoxStatus status;
+        do {
+            if (s & BUSY) {
+                s = stableState();
+            }
+            status = Rules::checkTake(s & OPEN, s & FULL);
+            if (status != BoxStatus::OK) {
+                return status;
+            }
+        } while (!state.compare_exchange_weak(s, advance(s, OPEN | FULL | BUSY), std::memory_order_acquire, std::memory_order_acquire));
+        item = loadItem();
+        state.store(advance(s + VERSION, OPEN), std::memory_order_release);
+        return status;
+    }
+
+    std::string ConcurrentBox::toString() const {
+        return load().toString();
+    }
+}
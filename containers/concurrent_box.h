@@ -0,0 +1,77 @@
+#ifndef CONCURRENT_BOX_H
+#define CONCURRENT_BOX_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "box.h"
+#include "box_value.h"
+#include "dimensions.h"
+
+namespace Containers {
+
+    /** ConcurrentBox is a Box which can be shared between threads without external locking.
+     * The open and full flags live in one atomic state word together with a version number, and every
+     * transition is a single compare-and-swap on it, so exactly one of the competing threads succeeds.
+     * While an item is being put in or taken out the state is marked busy, readers of the item retry
+     * until the state is stable again. Rules and exceptions are the same as for Box.
+     */
+    class ConcurrentBox {
+       private:
+        static const std::uint64_t OPEN = 1, FULL = 2, BUSY = 4, FLAGS = 7, VERSION = 8;
+
+        const long long ID;
+        const Dimensions size;
+        std::atomic<std::uint64_t> state;
+        std::atomic<int> itemLength, itemWidth, itemHeight;
+
+        /** Returns a state with given flags and a version following the one of previous */
+        static std::uint64_t advance(std::uint64_t previous, std::uint64_t flags);
+
+        /** Loads a state which is not busy */
+        std::uint64_t stableState() const;
+        Dimensions loadItem() const;
+        void storeItem(const Dimensions &item);
+
+       public:
+        /** Constructs a closed empty box, numbered the same way as Box(const Dimensions &)
+         * @param size the dimensions, all of them must be positive
+         */
+        explicit ConcurrentBox(const Dimensions &size);
+
+        /** Copies the state and ID of a box value */
+        explicit ConcurrentBox(const BoxValue &b);
+
+        ConcurrentBox(const ConcurrentBox &b) = delete;
+        ConcurrentBox &operator=(const ConcurrentBox &b) = delete;
+
+        /** Returns a consistent snapshot of the box */
+        BoxValue load() const;
+
+        long long getId() const;
+        Dimensions getSize() const;
+        bool isFull() const;
+        bool isClosed() const;
+
+        void open();
+        void close();
+
+        /** @see Box::putItem */
+        void putItem(const Dimensions &item);
+
+        /** @see Box::takeItem */
+        Dimensions takeItem();
+
+        /* @see Box::tryOpen */
+        BoxStatus tryOpen() noexcept;
+        BoxStatus tryClose() noexcept;
+        BoxStatus tryPutItem(const Dimensions &item) noexcept;
+        BoxStatus tryTakeItem(Dimensions &item) noexcept;
+
+        std::string toString() const;
+    };
+
+}
+
+#endif /* CONCURRENT_BOX_H */
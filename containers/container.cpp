@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <climits>
+
+#include "container.h"
+#include "internal.h"
+
+namespace Containers {
+
+    /** Grid cells along each axis, fewer when the container is smaller than this */
+    static const int GRID_CELLS = 32;
+
+    static void toArray(const Dimensions &d, int *out) {
+        out[0] = d.getLength();
+        out[1] = d.getWidth();
+        out[2] = d.getHeight();
+    }
+
+    static long long volumeOf(const Dimensions &d) {
+        return (long long)d.getLength() * d.getWidth() * d.getHeight();
+    }
+
+    Container::Container(const Dimensions &size) : usedVolume(0) {
+        validateDimensions(size);
+        toArray(size, dims);
+        std::size_t total = 1;
+        for (int axis = 0; axis < 3; ++axis) {
+            cells[axis] = std::min(dims[axis], GRID_CELLS);
+            total *= cells[axis];
+        }
+        grid.resize(total);
+        clear();
+    }
+
+    int Container::cellOf(int coordinate, int axis) const {
+        return std::min<long long>(cells[axis] - 1, (long long)coordinate * cells[axis] / dims[axis]);
+    }
+
+    std::size_t Container::cellIndex(int cx, int cy, int cz) const {
+        return ((std::size_t)cz * cells[1] + cy) * cells[0] + cx;
+    }
+
+    bool Container::isFree(const int *at, const int *item) const {
+        int from[3], to[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            if ((long long)at[axis] + item[axis] > dims[axis]) {
+                return false;
+            }
+            from[axis] = cellOf(at[axis], axis);
+            to[axis] = cellOf(at[axis] + item[axis] - 1, axis);
+        }
+        for (int cz = from[2]; cz <= to[2]; ++cz) {
+            for (int cy = from[1]; cy <= to[1]; ++cy) {
+                for (int cx = from[0]; cx <= to[0]; ++cx) {
+                    const std::vector<std::size_t> &cell = grid[cellIndex(cx, cy, cz)];
+                    for (std::size_t i = 0; i < cell.size(); ++i) {
+                        const Extent &e = extents[cell[i]];
+                        if (e.min[0] < at[0] + item[0] && at[0] < e.max[0] && e.min[1] < at[1] + item[1] && at[1] < e.max[1] &&
+                            e.min[2] < at[2] + item[2] && at[2] < e.max[2]) {
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    int Container::project(const Point &p, int axis) const {
+        int a = (axis + 1) % 3, b = (axis + 2) % 3;
+        int cell[3];
+        cell[a] = cellOf(p.at[a], a);
+        cell[b] = cellOf(p.at[b], b);
+        int reached = 0;
+        for (int c = cellOf(p.at[axis], axis); c >= 0; --c) {
+            /* The items not seen yet end at the latest where the cell above starts */
+            if (reached >= ((long long)(c + 1) * dims[axis] + cells[axis] - 1) / cells[axis]) {
+                break;
+            }
+            cell[axis] = c;
+            const std::vector<std::size_t> &items = grid[cellIndex(cell[0], cell[1], cell[2])];
+            for (std::size_t i = 0; i < items.size(); ++i) {
+                const Extent &e = extents[items[i]];
+                if (e.max[axis] <= p.at[axis] && e.max[axis] > reached && e.min[a] <= p.at[a] && p.at[a] < e.max[a] && e.min[b] <= p.at[b] &&
+                    p.at[b] < e.max[b]) {
+                    reached = e.max[axis];
+                }
+            }
+        }
+        return reached;
+    }
+
+    int Container::reach(const Point &p, int axis) const {
+        int a = (axis + 1) % 3, b = (axis + 2) % 3;
+        int cell[3];
+        cell[a] = cellOf(p.at[a], a);
+        cell[b] = cellOf(p.at[b], b);
+        int reached = dims[axis];
+        for (int c = cellOf(p.at[axis], axis); c < cells[axis]; ++c) {
+            /* The items not seen yet start at the earliest where this cell starts */
+            if (reached <= ((long long)c * dims[axis] + cells[axis] - 1) / cells[axis]) {
+                break;
+            }
+            cell[axis] = c;
+            const std::vector<std::size_t> &items = grid[cellIndex(cell[0], cell[1], cell[2])];
+            for (std::size_t i = 0; i < items.size(); ++i) {
+                const Extent &e = extents[items[i]];
+                if (e.min[axis] >= p.at[axis] && e.min[axis] < reached && e.min[a] <= p.at[a] && p.at[a] < e.max[a] && e.min[b] <= p.at[b] &&
+                    p.at[b] < e.max[b]) {
+                    reached = e.min[axis];
+                }
+            }
+        }
+        return reached - p.at[axis];
+    }
+
+    bool Container::findSpot(const Dimensions &item, bool allowRotation, Placement &spot) {
+        int sizes[6][3];
+        toArray(item, sizes[0]);
+        int orientations = 1;
+        if (allowRotation) {
+            static const int PERMUTATIONS[5][3] = {{0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+            for (int r = 0; r < 5; ++r) {
+                int *s = sizes[orientations];
+                for (int axis = 0; axis < 3; ++axis) {
+                    s[axis] = sizes[0][PERMUTATIONS[r][axis]];
+                }
+                bool repeated = false;
+                for (int o = 0; o < orientations; ++o) {
+                    repeated = repeated || std::equal(s, s + 3, sizes[o]);
+                }
+                orientations += !repeated;
+            }
+        }
+        for (std::size_t z = 0; z < layers.size(); ++z) {
+            Layer &layer = layers[z];
+            bool possible = false;
+            for (int o = 0; o < orientations; ++o) {
+                possible = possible || (sizes[o][0] <= layer.maxRoom[0] && sizes[o][1] <= layer.maxRoom[1] && sizes[o][2] <= layer.maxRoom[2]);
+            }
+            if (!possible) {
+                continue;
+            }
+            int maxRoom[3] = {0, 0, 0};
+            for (std::set<Point>::const_iterator it = layer.points.begin(); it != layer.points.end(); ++it) {
+                const int *room = it->room, *blocked = it->blocked;
+                for (int o = 0; o < orientations; ++o) {
+                    const int *s = sizes[o];
+                    if (s[0] > room[0] || s[1] > room[1] || s[2] > room[2] || (s[0] >= blocked[0] && s[1] >= blocked[1] && s[2] >= blocked[2])) {
+                        continue;
+                    }
+                    if (isFree(it->at, s)) {
+                        spot.item = Dimensions(s[0], s[1], s[2]);
+                        spot.x = it->at[0];
+                        spot.y = it->at[1];
+                        spot.z = it->at[2];
+                        return true;
+                    }
+                    if ((long long)s[0] * s[1] * s[2] < (long long)blocked[0] * blocked[1] * blocked[2] || blocked[0] == INT_MAX) {
+                        std::copy(s, s + 3, it->blocked);
+                    }
+                }
+                for (int axis = 0; axis < 3; ++axis) {
+                    maxRoom[axis] = std::max(maxRoom[axis], room[axis]);
+                }
+            }
+            std::copy(maxRoom, maxRoom + 3, layer.maxRoom);
+        }
+        return false;
+    }
+
+    void Container::addPoint(Point p) {
+        static const int UNIT[3] = {1, 1, 1};
+        if (!isFree(p.at, UNIT)) {
+            return;
+        }
+        for (int axis = 0; axis < 3; ++axis) {
+            p.room[axis] = reach(p, axis);
+            p.blocked[axis] = INT_MAX;
+        }
+        Layer &layer = layers[cellOf(p.at[2], 2)];
+        if (layer.points.insert(p).second) {
+            for (int axis = 0; axis < 3; ++axis) {
+                layer.maxRoom[axis] = std::max(layer.maxRoom[axis], p.room[axis]);
+            }
+        }
+    }
+
+    void Container::place(const Placement &p) {
+        Extent e = {{p.x, p.y, p.z}, {p.x + p.item.getLength(), p.y + p.item.getWidth(), p.z + p.item.getHeight()}};
+        std::size_t index = extents.size();
+        placements.push_back(p);
+        extents.push_back(e);
+        usedVolume += volumeOf(p.item);
+        for (int cz = cellOf(e.min[2], 2); cz <= cellOf(e.max[2] - 1, 2); ++cz) {
+            for (int cy = cellOf(e.min[1], 1); cy <= cellOf(e.max[1] - 1, 1); ++cy) {
+                for (int cx = cellOf(e.min[0], 0); cx <= cellOf(e.max[0] - 1, 0); ++cx) {
+                    grid[cellIndex(cx, cy, cz)].push_back(index);
+                }
+            }
+        }
+
+        for (int z = cellOf(e.min[2], 2); z <= cellOf(e.max[2] - 1, 2); ++z) {
+            std::set<Point> &points = layers[z].points;
+            for (std::set<Point>::iterator it = points.begin(); it != points.end();) {
+                const int *at = it->at;
+                bool coversX = e.min[0] <= at[0] && at[0] < e.max[0], coversY = e.min[1] <= at[1] && at[1] < e.max[1];
+                if (e.min[2] > at[2] || at[2] >= e.max[2]) {
+                    ++it;
+                    continue;
+                }
+                if (coversX && coversY) {
+                    points.erase(it++);
+                    continue;
+                }
+                if (coversY && e.min[0] >= at[0]) {
+                    it->room[0] = std::min(it->room[0], e.min[0] - at[0]);
+                }
+                if (coversX && e.min[1] >= at[1]) {
+                    it->room[1] = std::min(it->room[1], e.min[1] - at[1]);
+                }
+                ++it;
+            }
+        }
+
+        /* Each corner next to the item along one axis is projected towards the origin along the other two */
+        for (int axis = 0; axis < 3; ++axis) {
+            Point corner = {{e.min[0], e.min[1], e.min[2]}};
+            corner.at[axis] = e.max[axis];
+            if (corner.at[axis] >= dims[axis]) {
+                continue;
+            }
+            for (int along = 0; along < 3; ++along) {
+                if (along != axis) {
+                    Point projected = corner;
+                    projected.at[along] = project(corner, along);
+                    addPoint(projected);
+                }
+            }
+        }
+    }
+
+    bool Container::insert(const Dimensions &item, bool allowRotation) {
+        validateDimensions(item);
+        if (volumeOf(item) > (long long)dims[0] * dims[1] * dims[2] - usedVolume) {
+            return false;
+        }
+        Placement spot;
+        if (!findSpot(item, allowRotation, spot)) {
+            return false;
+        }
+        place(spot);
+        return true;
+    }
+
+    std::size_t Container::insert(const Dimensions *items, std::size_t count, bool allowRotation) {
+        std::vector<bool> placed;
+        return insert(items, count, placed, allowRotation);
+    }
+
+    std::size_t Container::insert(const Dimensions *items, std::size_t count, std::vector<bool> &placed, bool allowRotation) {
+        for (std::size_t i = 0; i < count; ++i) {
+            validateDimensions(items[i]);
+        }
+        std::vector<std::size_t> order(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [items](std::size_t a, std::size_t b) { return volumeOf(items[a]) > volumeOf(items[b]); });
+        placed.assign(count, false);
+        std::size_t total = 0;
+        for (std::size_t k = 0; k < count; ++k) {
+            if (insert(items[order[k]], allowRotation)) {
+                placed[order[k]] = true;
+                ++total;
+            }
+        }
+        return total;
+    }
+
+    void Container::clear() {
+        placements.clear();
+        extents.clear();
+        for (std::size_t i = 0; i < grid.size(); ++i) {
+            grid[i].clear();
+        }
+        layers.assign(cells[2], Layer());
+        for (std::size_t z = 0; z < layers.size(); ++z) {
+            std::fill(layers[z].maxRoom, layers[z].maxRoom + 3, 0);
+        }
+        usedVolume = 0;
+        Point origin = {{0, 0, 0}};
+        addPoint(origin);
+    }
+
+    Dimensions Container::getSize() const {
+        return Dimensions(dims[0], dims[1], dims[2]);
+    }
+
+    std::size_t Container::getItemCount() const {
+        return placements.size();
+    }
+
+    const std::vector<Placement> &Container::getPlacements() const {
+        return placements;
+    }
+
+    long long Container::getUsedVolume() const {
+        return usedVolume;
+    }
+
+    double Container::getFillRatio() const {
+        return (double)usedVolume / ((double)dims[0] * dims[1] * dims[2]);
+    }
+}
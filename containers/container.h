@@ -0,0 +1,109 @@
+#ifndef CONTAINER_H
+#define CONTAINER_H
+
+#include <cstddef>
+#include <set>
+#include <vector>
+
+#include "dimensions.h"
+
+namespace Containers {
+
+    /** Where an item was put into a Container: the corner nearest to the origin and the item as oriented */
+    struct Placement {
+        Dimensions item;
+        int x, y, z;
+    };
+
+    /** Container holds many items, unlike Box, packing each one where it still fits.
+     *
+     * Placement follows the extreme point heuristic: items are only tried at the corners left by the items
+     * already placed and the walls, projected towards the origin, lowest first. Placed items are kept in a
+     * uniform grid over the container, so checking that a spot is free or projecting a corner only looks at
+     * the items in the grid cells it touches instead of every item. The corners are kept in horizontal layers
+     * of the grid, each knowing an upper bound of the free room around its corners, so an item skips every
+     * layer without enough room for it. Items never move once placed.
+     */
+    class Container {
+       private:
+        /** A corner as x, y, z, ordered lowest first, then by y and x */
+        struct Point {
+            int at[3];
+            /** The free length from the corner to the nearest item or wall along each axis, no larger item fits
+             * there. Only kept up to date along x and y, along z it may be too large. */
+            mutable int room[3];
+            /** An item which did not fit at the corner. Free space only shrinks, so no item at least as large along
+             * every axis fits there either. */
+            mutable int blocked[3];
+
+            bool operator<(const Point &p) const {
+                for (int axis = 2; axis >= 0; --axis) {
+                    if (at[axis] != p.at[axis]) {
+                        return at[axis] < p.at[axis];
+                    }
+                }
+                return false;
+            }
+        };
+
+        /** The corners within one horizontal layer of grid cells */
+        struct Layer {
+            std::set<Point> points;
+            /** An upper bound of the room of every corner in the layer along each axis */
+            int maxRoom[3];
+        };
+
+        /** The space taken by a placed item, from min inclusive to max exclusive on each axis */
+        struct Extent {
+            int min[3], max[3];
+        };
+
+        int dims[3];
+        std::vector<Placement> placements;
+        std::vector<Extent> extents;
+        int cells[3];
+        /** Indexes of the placements touching each grid cell */
+        std::vector<std::vector<std::size_t> > grid;
+        /** Extreme points, the candidate spots for the next item, in the layer of their height */
+        std::vector<Layer> layers;
+        long long usedVolume;
+
+        int cellOf(int coordinate, int axis) const;
+        std::size_t cellIndex(int cx, int cy, int cz) const;
+        bool isFree(const int *at, const int *item) const;
+        int project(const Point &p, int axis) const;
+        int reach(const Point &p, int axis) const;
+        void addPoint(Point p);
+        bool findSpot(const Dimensions &item, bool allowRotation, Placement &spot);
+        void place(const Placement &p);
+
+       public:
+        /** @param size the dimensions, all of them must be positive */
+        explicit Container(const Dimensions &size);
+
+        /** Places an item, trying its six axis-aligned orientations when allowRotation is set
+         * @param item the dimensions, all of them must be positive
+         * @return false if there is no room left for the item
+         */
+        bool insert(const Dimensions &item, bool allowRotation = false);
+
+        /* Place a batch of items, the largest volumes first, and return how many of them were placed.
+         * placed receives whether each item, in the given order, was placed. */
+        std::size_t insert(const Dimensions *items, std::size_t count, bool allowRotation = false);
+        std::size_t insert(const Dimensions *items, std::size_t count, std::vector<bool> &placed, bool allowRotation = false);
+
+        /** Removes every item */
+        void clear();
+
+        Dimensions getSize() const;
+        std::size_t getItemCount() const;
+        const std::vector<Placement> &getPlacements() const;
+        long long getUsedVolume() const;
+
+        /** The share of the container volume taken by items, between 0 and 1 */
+        double getFillRatio() const;
+    };
+
+}
+
+#endif /* CONTAINER_H */
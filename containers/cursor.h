@@ -0,0 +1,292 @@
+#ifndef CURSOR_H
+#define CURSOR_H
+
+#include <cstring>
+
+#include "box_value.h"
+#include "internal.h"
+#include "parser.h"
+
+namespace Containers {
+
+    namespace Serialization {
+
+        enum class Field : unsigned char { UNKNOWN, ID, IS_OPEN, SIZE, ITEM, LENGTH, WIDTH, HEIGHT };
+
+        inline bool isSpace(char c) {
+            return c == ' ' || (c >= '\t' && c <= '\r');
+        }
+
+        /** Returns the first BEGIN_MARK at or after position which starts a box rather than a value,
+         * or end if there is none. begin is where the text starts, the search may look back to it. */
+        inline const char *nextRecordStart(const char *begin, const char *position, const char *end) {
+            const char *previous = position;
+            while (previous != begin && isSpace(previous[-1])) {
+                --previous;
+            }
+            char last = previous == begin ? BEGIN_MARK : previous[-1];
+            for (; position != end; ++position) {
+                if (*position == BEGIN_MARK && last != VALUE_MARK) {
+                    return position;
+                }
+                if (!isSpace(*position)) {
+                    last = *position;
+                }
+            }
+            return end;
+        }
+
+        /** Throws the exception of a failed parse, telling where it happened */
+        [[noreturn]] void raiseParseError(const ParseResult &result, unsigned long long line, unsigned long long offset);
+
+        /** Reads the text format from a character buffer the same way the stream operators read it.
+         * Every read returns false on failure, leaving the reason in error and the offending character
+         * at position.
+         */
+        class Cursor {
+           public:
+            const char *begin, *position, *end;
+            ParseError error;
+
+            Cursor(const char *begin, const char *end) : begin(begin), position(begin), end(end), error(ParseError::NONE) {
+            }
+
+            std::size_t offset() const {
+                return position - begin;
+            }
+
+            bool fail(ParseError e) {
+                error = e;
+                return false;
+            }
+
+            /** Moves to the next non-whitespace character, which must exist */
+            bool skipSpace() {
+                while (position != end && isSpace(*position)) {
+                    ++position;
+                }
+                return position != end || fail(ParseError::UNEXPECTED_END);
+            }
+
+            bool readMark(char mark) {
+                if (!skipSpace()) {
+                    return false;
+                }
+                if (*position != mark) {
+                    return fail(ParseError::INVALID_SYMBOL);
+                }
+                ++position;
+                return true;
+            }
+
+            /** Reads VALUE_SEPARATOR or END_MARK, more tells which one it was */
+            bool readNextSeparator(bool &more) {
+                if (!skipSpace()) {
+                    return false;
+                }
+                if (*position != VALUE_SEPARATOR && *position != END_MARK) {
+                    return fail(ParseError::INVALID_SYMBOL);
+                }
+                more = *position++ == VALUE_SEPARATOR;
+                return true;
+            }
+
+            /** Reads a whitespace delimited field name followed by VALUE_MARK */
+            bool readValueName(Field &field) {
+                if (!skipSpace()) {
+                    return false;
+                }
+                const char *name = position;
+                while (position != end && !isSpace(*position)) {
+                    ++position;
+                }
+                if (position == end) {
+                    return fail(ParseError::UNEXPECTED_END);
+                }
+                const char *nameEnd = position;
+                if (nameEnd[-1] == VALUE_MARK) {
+                    --nameEnd;
+                } else if (!readMark(VALUE_MARK)) {
+                    return false;
+                }
+                field = fieldOf(name, nameEnd - name);
+                if (field == Field::UNKNOWN) {
+                    position = name;
+                    return fail(ParseError::UNKNOWN_VALUE);
+                }
+                return true;
+            }
+
+            static Field fieldOf(const char *name, std::size_t length) {
+                switch (length) {
+                    case 2:
+                        return matches(name, length, Box::FIELD_ID) ? Field::ID : Field::UNKNOWN;
+                    case 4:
+                        return matches(name, length, Box::FIELD_SIZE) ? Field::SIZE : matches(name, length, Box::FIELD_ITEM) ? Field::ITEM : Field::UNKNOWN;
+                    case 5:
+                        return matches(name, length, Dimensions::FIELD_WIDTH) ? Field::WIDTH : Field::UNKNOWN;
+                    case 6:
+                        return matches(name, length, Dimensions::FIELD_LENGTH) ? Field::LENGTH
+                               : matches(name, length, Dimensions::FIELD_HEIGHT) ? Field::HEIGHT
+                                                                                  : Field::UNKNOWN;
+                    case 7:
+                        return matches(name, length, Box::FIELD_IS_OPEN) ? Field::IS_OPEN : Field::UNKNOWN;
+                }
+                return Field::UNKNOWN;
+            }
+
+            static bool matches(const char *name, std::size_t length, const string &field) {
+                return field.size() == length && std::memcmp(name, field.data(), length) == 0;
+            }
+
+            /** Reads an integer like operator>>(long long &), a number touching the end of input may be incomplete */
+            bool readNumber(long long &value, long long min, long long max) {
+                if (!skipSpace()) {
+                    return false;
+                }
+                const char *start = position;
+                bool negative = false;
+                if (*position == '-' || *position == '+') {
+                    negative = *position++ == '-';
+                }
+                unsigned long long magnitude = 0, limit = negative ? 0ULL - (unsigned long long)min : (unsigned long long)max;
+                const char *digits = position;
+                while (position != end && *position >= '0' && *position <= '9') {
+                    unsigned digit = *position - '0';
+                    if (magnitude > (limit - digit) / 10) {
+                        position = start;
+                        return fail(ParseError::INVALID_NUMBER);
+                    }
+                    magnitude = magnitude * 10 + digit;
+                    ++position;
+                }
+                if (position == end) {
+                    return fail(ParseError::UNEXPECTED_END);
+                }
+                if (position == digits) {
+                    return fail(ParseError::INVALID_NUMBER);
+                }
+                value = negative ? (long long)(0ULL - magnitude) : (long long)magnitude;
+                return true;
+            }
+
+            bool readInt(int &value) {
+                long long tmp;
+                if (!readNumber(tmp, -2147483647LL - 1, 2147483647LL)) {
+                    return false;
+                }
+                value = (int)tmp;
+                return true;
+            }
+
+            /** Reads TRUE or FALSE */
+            bool readBool(bool &value) {
+                if (!skipSpace()) {
+                    return false;
+                }
+                const string &expected = *position == TRUE[0] ? TRUE : FALSE;
+                for (std::size_t i = 0; i < expected.size(); ++i, ++position) {
+                    if (position == end) {
+                        return fail(ParseError::UNEXPECTED_END);
+                    }
+                    if (*position != expected[i]) {
+                        return fail(ParseError::INVALID_SYMBOL);
+                    }
+                }
+                value = &expected == &TRUE;
+                return true;
+            }
+
+            /** Skips a value without reading it, a nested value up to its END_MARK, anything else up to the next
+             * VALUE_SEPARATOR or END_MARK. Only the marks are checked, not the skipped text. */
+            bool skipValue() {
+                if (!skipSpace()) {
+                    return false;
+                }
+                if (*position == BEGIN_MARK) {
+                    const char *close = static_cast<const char *>(std::memchr(position, END_MARK, end - position));
+                    if (close == NULL) {
+                        position = end;
+                        return fail(ParseError::UNEXPECTED_END);
+                    }
+                    position = close + 1;
+                    return true;
+                }
+                while (position != end && *position != VALUE_SEPARATOR && *position != END_MARK) {
+                    ++position;
+                }
+                return position != end || fail(ParseError::UNEXPECTED_END);
+            }
+
+            bool readDimensions(Containers::Dimensions &d) {
+                int length = 0, width = 0, height = 0;
+                bool more;
+                if (!readMark(BEGIN_MARK)) {
+                    return false;
+                }
+                do {
+                    Field field;
+                    if (!readValueName(field)) {
+                        return false;
+                    }
+                    bool read;
+                    if (field == Field::LENGTH) {
+                        read = readInt(length);
+                    } else if (field == Field::WIDTH) {
+                        read = readInt(width);
+                    } else if (field == Field::HEIGHT) {
+                        read = readInt(height);
+                    } else {
+                        return fail(ParseError::UNKNOWN_VALUE);
+                    }
+                    if (!read || !readNextSeparator(more)) {
+                        return false;
+                    }
+                } while (more);
+                d = Containers::Dimensions(length, width, height);
+                return true;
+            }
+
+            /** Reads the fields of a Box record without checking any box rules.
+             * Fields with their bit (1 << Field) set in skip are skipped with skipValue(), a skipped item still sets hasItem. */
+            bool readBoxRecord(BoxRecord &record, unsigned skip = 0) {
+                record.id = 0;
+                record.isOpen = record.hasItem = false;
+                record.size = record.item = Containers::Dimensions();
+                bool more;
+                if (!readMark(BEGIN_MARK)) {
+                    return false;
+                }
+                do {
+                    Field field;
+                    if (!readValueName(field)) {
+                        return false;
+                    }
+                    bool read;
+                    if (skip >> static_cast<unsigned>(field) & 1) {
+                        read = skipValue();
+                        record.hasItem |= field == Field::ITEM;
+                    } else if (field == Field::IS_OPEN) {
+                        read = readBool(record.isOpen);
+                    } else if (field == Field::SIZE) {
+                        read = readDimensions(record.size);
+                    } else if (field == Field::ITEM) {
+                        read = readDimensions(record.item);
+                        record.hasItem = true;
+                    } else if (field == Field::ID) {
+                        read = readNumber(record.id, -9223372036854775807LL - 1, 9223372036854775807LL);
+                    } else {
+                        return fail(ParseError::UNKNOWN_VALUE);
+                    }
+                    if (!read || !readNextSeparator(more)) {
+                        return false;
+                    }
+                } while (more);
+                return true;
+            }
+        };
+    }
+
+}
+
+#endif /* CURSOR_H */
@@ -1,5 +1,3 @@
-#include <sstream>
-
 #include "dimensions.h"
 #include "internal.h"
 
@@ -40,25 +38,13 @@ namespace Containers {
     }
 
     string Dimensions::toString() const {
-        std::ostringstream output;
-        output << Serialization::BEGIN_MARK;
-
-        output << Serialization::Dimensions::FIELD_LENGTH << Serialization::VALUE_MARK << ' ';
-        output << this->length << Serialization::VALUE_SEPARATOR << ' ';
-
-        output << Serialization::Dimensions::FIELD_WIDTH << Serialization::VALUE_MARK << ' ';
-        output << this->width << Serialization::VALUE_SEPARATOR << ' ';
-
-        output << Serialization::Dimensions::FIELD_HEIGHT << Serialization::VALUE_MARK << ' ';
-        output << this->height;
-
-        output << Serialization::END_MARK;
-        return output.str();
+        char text[Serialization::MAX_BOX_TEXT];
+        return string(text, Serialization::formatDimensions(text, *this));
     }
 
     std::ostream &operator<<(std::ostream &o, const Dimensions &d) {
-        o << d.toString();
-        return o;
+        char text[Serialization::MAX_BOX_TEXT];
+        return Serialization::writeText(o, text, Serialization::formatDimensions(text, d) - text);
     }
 
     std::istream &operator>>(std::istream &s, Dimensions &d) {
@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <climits>
+#include <utility>
+
+#include "fit_index.h"
+#include "internal.h"
+
+namespace Containers {
+
+    /** Boxes gathered before they are merged into a tree, level i of the trees holds up to BUFFER_SIZE << i boxes */
+    static const std::size_t BUFFER_SIZE = 64;
+
+    static std::size_t middle(std::size_t lo, std::size_t hi) {
+        return lo + (hi - lo) / 2;
+    }
+
+    static bool fits(int length, int width, int height, const Dimensions &item) {
+        return length >= item.getLength() && width >= item.getWidth() && height >= item.getHeight();
+    }
+
+    FitIndex::Tree::Tree() : active(0) {
+    }
+
+    void FitIndex::Tree::build(std::size_t lo, std::size_t hi, int depth) {
+        if (lo >= hi) {
+            return;
+        }
+        std::size_t mid = middle(lo, hi);
+        int axis = depth % 3;
+        std::nth_element(nodes.begin() + lo, nodes.begin() + mid, nodes.begin() + hi, [axis](const Node &a, const Node &b) {
+            return axis == 0 ? a.length < b.length : axis == 1 ? a.width < b.width : a.height < b.height;
+        });
+        build(lo, mid, depth + 1);
+        build(mid + 1, hi, depth + 1);
+        refresh(lo, hi);
+    }
+
+    void FitIndex::Tree::refresh(std::size_t lo, std::size_t hi) {
+        std::size_t mid = middle(lo, hi);
+        Node &n = nodes[mid];
+        if (n.active) {
+            n.minVolume = n.volume;
+            n.maxLength = n.length;
+            n.maxWidth = n.width;
+            n.maxHeight = n.height;
+        } else {
+            n.minVolume = LLONG_MAX;
+            n.maxLength = n.maxWidth = n.maxHeight = 0;
+        }
+        std::size_t children[2] = {lo < mid ? middle(lo, mid) : mid, mid + 1 < hi ? middle(mid + 1, hi) : mid};
+        for (int i = 0; i < 2; ++i) {
+            if (children[i] != mid) {
+                const Node &c = nodes[children[i]];
+                n.minVolume = std::min(n.minVolume, c.minVolume);
+                n.maxLength = std::max(n.maxLength, c.maxLength);
+                n.maxWidth = std::max(n.maxWidth, c.maxWidth);
+                n.maxHeight = std::max(n.maxHeight, c.maxHeight);
+            }
+        }
+    }
+
+    void FitIndex::Tree::search(std::size_t lo, std::size_t hi, const Dimensions &item, const Node *&best) const {
+        if (lo >= hi) {
+            return;
+        }
+        std::size_t mid = middle(lo, hi);
+        const Node &n = nodes[mid];
+        if (!fits(n.maxLength, n.maxWidth, n.maxHeight, item) || (best != NULL && n.minVolume >= best->volume)) {
+            return;
+        }
+        if (n.active && fits(n.length, n.width, n.height, item) && (best == NULL || n.volume < best->volume)) {
+            best = &n;
+        }
+        /* The subtree holding the smaller volume goes first, so the other one is more likely to be pruned */
+        if (mid + 1 < hi && lo < mid && nodes[middle(mid + 1, hi)].minVolume < nodes[middle(lo, mid)].minVolume) {
+            search(mid + 1, hi, item, best);
+            search(lo, mid, item, best);
+        } else {
+            search(lo, mid, item, best);
+            search(mid + 1, hi, item, best);
+        }
+    }
+
+    void FitIndex::Tree::build(std::vector<Node> &items) {
+        nodes.swap(items);
+        items.clear();
+        active = nodes.size();
+        build(0, nodes.size(), 0);
+    }
+
+    void FitIndex::Tree::drain(std::vector<Node> &out) {
+        for (std::size_t i = 0; i < nodes.size(); ++i) {
+            if (nodes[i].active) {
+                out.push_back(nodes[i]);
+            }
+        }
+        nodes.clear();
+        active = 0;
+    }
+
+    void FitIndex::Tree::deactivate(std::size_t pos) {
+        std::vector<std::pair<std::size_t, std::size_t> > path;
+        std::size_t lo = 0, hi = nodes.size();
+        while (true) {
+            path.push_back(std::make_pair(lo, hi));
+            std::size_t mid = middle(lo, hi);
+            if (pos == mid) {
+                break;
+            }
+            if (pos < mid) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+        }
+        nodes[pos].active = false;
+        --active;
+        for (std::size_t i = path.size(); i-- > 0;) {
+            refresh(path[i].first, path[i].second);
+        }
+    }
+
+    void FitIndex::Tree::search(const Dimensions &item, const Node *&best) const {
+        search(0, nodes.size(), item, best);
+    }
+
+    FitIndex::FitIndex() {
+    }
+
+    void FitIndex::place(int level) {
+        const std::vector<Node> &nodes = levels[level].getNodes();
+        for (std::size_t i = 0; i < nodes.size(); ++i) {
+            Location &l = locations[nodes[i].id];
+            l.level = level;
+            l.pos = i;
+        }
+    }
+
+    void FitIndex::flush() {
+        std::vector<Node> items;
+        items.swap(buffer);
+        for (std::size_t level = 0;; ++level) {
+            if (level == levels.size()) {
+                levels.push_back(Tree());
+            }
+            levels[level].drain(items);
+            if (items.size() <= BUFFER_SIZE << level) {
+                levels[level].build(items);
+                place(level);
+                return;
+            }
+        }
+    }
+
+    bool FitIndex::insert(long long id, const Dimensions &size) {
+        validateDimensions(size);
+        if (locations.count(id) != 0) {
+            return false;
+        }
+        long long volume = (long long)size.getLength() * size.getWidth() * size.getHeight();
+        Node n = {id, volume, size.getLength(), size.getWidth(), size.getHeight(), true, volume, size.getLength(), size.getWidth(), size.getHeight()};
+        Location l = {-1, buffer.size()};
+        locations[id] = l;
+        buffer.push_back(n);
+        if (buffer.size() >= BUFFER_SIZE) {
+            flush();
+        }
+        return true;
+    }
+
+    bool FitIndex::insert(const Box &b) {
+        return insert(BoxValue(b));
+    }
+
+    bool FitIndex::insert(const BoxValue &b) {
+        return !b.isFull() && insert(b.getId(), b.getSize());
+    }
+
+    bool FitIndex::erase(long long id) {
+        std::unordered_map<long long, Location>::iterator it = locations.find(id);
+        if (it == locations.end()) {
+            return false;
+        }
+        Location l = it->second;
+        locations.erase(it);
+        if (l.level < 0) {
+            buffer[l.pos] = buffer.back();
+            buffer.pop_back();
+            if (l.pos < buffer.size()) {
+                locations[buffer[l.pos].id].pos = l.pos;
+            }
+            return true;
+        }
+        Tree &tree = levels[l.level];
+        tree.deactivate(l.pos);
+        if (tree.countActive() < tree.getNodes().size() / 2) {
+            std::vector<Node> items;
+            tree.drain(items);
+            tree.build(items);
+            place(l.level);
+        }
+        return true;
+    }
+
+    bool FitIndex::contains(long long id) const {
+        return locations.count(id) != 0;
+    }
+
+    std::size_t FitIndex::size() const {
+        return locations.size();
+    }
+
+    void FitIndex::clear() {
+        locations.clear();
+        buffer.clear();
+        levels.clear();
+    }
+
+    bool FitIndex::find(const Dimensions &item, const Node *&best) const {
+        best = NULL;
+        for (std::size_t i = 0; i < buffer.size(); ++i) {
+            const Node &n = buffer[i];
+            if (fits(n.length, n.width, n.height, item) && (best == NULL || n.volume < best->volume)) {
+                best = &n;
+            }
+        }
+        for (std::size_t i = 0; i < levels.size(); ++i) {
+            levels[i].search(item, best);
+        }
+        return best != NULL;
+    }
+
+    bool FitIndex::findSmallest(const Dimensions &item, long long &id) const {
+        const Node *best;
+        if (!find(item, best)) {
+            return false;
+        }
+        id = best->id;
+        return true;
+    }
+
+    bool FitIndex::findSmallest(const Dimensions &item, long long &id, Dimensions &size) const {
+        const Node *best;
+        if (!find(item, best)) {
+            return false;
+        }
+        id = best->id;
+        size = Dimensions(best->length, best->width, best->height);
+        return true;
+    }
+}
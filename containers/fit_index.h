@@ -0,0 +1,106 @@
+#ifndef FIT_INDEX_H
+#define FIT_INDEX_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "box.h"
+#include "box_value.h"
+#include "dimensions.h"
+
+namespace Containers {
+
+    /** FitIndex finds the smallest empty box an item can be put into and still be closed, following the rules
+     * of Box::putItem and Box::close: the length and width of the item must not exceed those of the box, and
+     * neither may its height. Boxes are keyed by ID and are removed once they are filled.
+     *
+     * The boxes are kept in k-d trees over length, width and height, each node knowing the largest sizes and
+     * the smallest volume below it, so a query skips every subtree that cannot fit the item or cannot beat the
+     * best box found so far. New boxes gather in a small buffer that is merged into trees of doubling
+     * capacity, erased boxes are only marked and dropped when their tree is rebuilt. Not thread-safe.
+     */
+    class FitIndex {
+       private:
+        struct Node {
+            long long id, volume;
+            int length, width, height;
+            bool active;
+            /* The largest sizes and the smallest volume among the active nodes of the subtree */
+            long long minVolume;
+            int maxLength, maxWidth, maxHeight;
+        };
+
+        /** A k-d tree stored in one array, the node of a range [lo, hi) sits at its middle */
+        class Tree {
+           private:
+            std::vector<Node> nodes;
+            std::size_t active;
+
+            void build(std::size_t lo, std::size_t hi, int depth);
+            void refresh(std::size_t lo, std::size_t hi);
+            void search(std::size_t lo, std::size_t hi, const Dimensions &item, const Node *&best) const;
+
+           public:
+            Tree();
+
+            /** Rebuilds the tree from the given nodes, leaving them in tree order */
+            void build(std::vector<Node> &items);
+
+            /** Appends the active nodes to out and empties the tree */
+            void drain(std::vector<Node> &out);
+            void deactivate(std::size_t pos);
+            void search(const Dimensions &item, const Node *&best) const;
+
+            const std::vector<Node> &getNodes() const {
+                return nodes;
+            }
+
+            std::size_t countActive() const {
+                return active;
+            }
+        };
+
+        /** Where a box is stored, level -1 is the buffer */
+        struct Location {
+            int level;
+            std::size_t pos;
+        };
+
+        std::unordered_map<long long, Location> locations;
+        std::vector<Node> buffer;
+        std::vector<Tree> levels;
+
+        void flush();
+        void place(int level);
+        bool find(const Dimensions &item, const Node *&best) const;
+
+       public:
+        FitIndex();
+
+        /** Indexes an empty box under its ID
+         * @return false if a box with the same ID is already indexed
+         */
+        bool insert(long long id, const Dimensions &size);
+
+        /** @return false if the box is full or a box with the same ID is already indexed */
+        bool insert(const Box &b);
+        bool insert(const BoxValue &b);
+
+        bool erase(long long id);
+        bool contains(long long id) const;
+        std::size_t size() const;
+        void clear();
+
+        /** Finds the box of the smallest volume that can take the item and still be closed
+         * @param id receives the ID of the box
+         * @param size receives the dimensions of the box
+         * @return false if no indexed box can take the item
+         */
+        bool findSmallest(const Dimensions &item, long long &id) const;
+        bool findSmallest(const Dimensions &item, long long &id, Dimensions &size) const;
+    };
+
+}
+
+#endif /* FIT_INDEX_H */
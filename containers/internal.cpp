@@ -8,8 +8,11 @@ namespace Containers {
 
         const string INVALID_SYMBOL = "Invalid symbol in stream";
         const string UNKNOWN_VALUE = "Unknown value in stream";
+        const string UNEXPECTED_END = "Unexpected end of stream";
+        const string INVALID_NUMBER = "Invalid number in stream";
 
         const string UNINITIALIZED_USAGE = "Attempted to use an uninitialized object";
+        const string CANNOT_OPEN = "Cannot open file";
 
         namespace Box {
             const string WRONG_INITIALIZATION = "Attempted to initialize an already initialized box";
@@ -27,6 +30,46 @@ namespace Containers {
             const string INVALID = "Dimensions contains invalid (non-positive) value";
         }
 
+        namespace BoxStore {
+            const string INVALID_HANDLE = "Box handle does not belong to the store";
+        }
+
+        namespace Binary {
+            const string INVALID_HEADER = "Stream does not contain a box snapshot";
+            const string UNSUPPORTED_VERSION = "Unsupported box snapshot version";
+            const string TRUNCATED = "Box snapshot is truncated";
+            const string IS_DELTA = "Box snapshot is a delta, it must be merged into its base";
+            const string NOT_DELTA = "Box snapshot is not a delta, it cannot be merged into a base";
+        }
+
+        namespace Snapshot {
+            const string CANNOT_OPEN = "Cannot open box snapshot";
+            const string CANNOT_WRITE = "Cannot write box snapshot";
+            const string NOT_INDEXED = "Box snapshot has no ID index";
+            const string INVALID_POSITION = "Position is past the end of the box snapshot";
+        }
+
+        namespace Reader {
+            const string RECORD_TOO_LONG = "Box record does not fit in the read buffer";
+        }
+
+        namespace Scanner {
+            const string TOO_LARGE = "Text is too large for a structural index";
+        }
+
+        namespace Journal {
+            const string INVALID_HEADER = "Box journal header is invalid";
+            const string CANNOT_WRITE = "Cannot write box journal";
+            const string UNKNOWN_BOX = "Box journal refers to an unknown box";
+            const string DUPLICATE_BOX = "Box journal gives a box the id of another box";
+            const string UNKNOWN_OPERATION = "Box journal contains an unknown operation";
+            const string FAILED = "Box journal lost records in a failed write and must be reset";
+        }
+
+        namespace Assignment {
+            const string TOO_LARGE = "Box volumes are too large for an optimal assignment";
+        }
+
     }
 
     namespace Serialization {
@@ -1,10 +1,14 @@
 #ifndef INTERNAL_H
 #define INTERNAL_H
 
+#include <atomic>
+#include <cstddef>
 #include <iostream>
 #include <string>
 
 #include "box.h"
+#include "box_store.h"
+#include "box_value.h"
 
 namespace Containers {
 
@@ -14,8 +18,11 @@ namespace Containers {
 
         extern const string INVALID_SYMBOL;
         extern const string UNKNOWN_VALUE;
+        extern const string UNEXPECTED_END;
+        extern const string INVALID_NUMBER;
 
         extern const string UNINITIALIZED_USAGE;
+        extern const string CANNOT_OPEN;
 
         namespace Box {
             extern const string WRONG_INITIALIZATION;
@@ -33,6 +40,46 @@ namespace Containers {
             extern const string INVALID;
         }
 
+        namespace BoxStore {
+            extern const string INVALID_HANDLE;
+        }
+
+        namespace Binary {
+            extern const string INVALID_HEADER;
+            extern const string UNSUPPORTED_VERSION;
+            extern const string TRUNCATED;
+            extern const string IS_DELTA;
+            extern const string NOT_DELTA;
+        }
+
+        namespace Snapshot {
+            extern const string CANNOT_OPEN;
+            extern const string CANNOT_WRITE;
+            extern const string NOT_INDEXED;
+            extern const string INVALID_POSITION;
+        }
+
+        namespace Reader {
+            extern const string RECORD_TOO_LONG;
+        }
+
+        namespace Scanner {
+            extern const string TOO_LARGE;
+        }
+
+        namespace Journal {
+            extern const string INVALID_HEADER;
+            extern const string CANNOT_WRITE;
+            extern const string UNKNOWN_BOX;
+            extern const string DUPLICATE_BOX;
+            extern const string UNKNOWN_OPERATION;
+            extern const string FAILED;
+        }
+
+        namespace Assignment {
+            extern const string TOO_LARGE;
+        }
+
     }
 
     namespace Serialization {
@@ -61,21 +108,252 @@ namespace Containers {
         void readMark(std::istream &s, char mark);
         bool readNextSeparator(std::istream &s);
         string readValueName(std::istream &s);
+
+        /** Upper bound of the length of a box in the toString() format */
+        const std::size_t MAX_BOX_TEXT = 256;
+
+        /* Write the toString() format to out and return the end of the written text, item is NULL for an empty box */
+        char *formatDimensions(char *out, const Containers::Dimensions &d);
+        char *formatBox(char *out, long long id, bool isOpen, const Containers::Dimensions *item, const Containers::Dimensions &size);
+
+        /** Writes already formatted text to a stream, honouring its field width like operator<<(std::ostream &, const string &) */
+        std::ostream &writeText(std::ostream &o, const char *text, std::size_t length);
+    }
+
+    void validateDimensions(Dimensions dimensions);
+
+    /** Hands out the next unused box ID. Each thread takes IDs from its own block of consecutive IDs. */
+    long long nextBoxId();
+
+    /** Read-only mapping of a whole file into memory */
+    class MappedFile {
+       private:
+        const char *data;
+        std::size_t length;
+
+       public:
+        /** Maps the file at path, throwing std::runtime_error if it cannot be opened */
+        explicit MappedFile(const std::string &path);
+        MappedFile(const MappedFile &f) = delete;
+        MappedFile &operator=(const MappedFile &f) = delete;
+        ~MappedFile();
+
+        const char *begin() const {
+            return data;
+        }
+
+        const char *end() const {
+            return data + length;
+        }
+
+        std::size_t size() const {
+            return length;
+        }
+    };
+
+    /* Every public Box method verifies that the Box is initialized. The amount of checking is chosen at
+     * compile time with -DCONTAINERS_CHECK_LEVEL=<level>:
+     *  2 - (default) the exception names the file, line and function of the failed check
+     *  1 - a bare null check, the exception carries only Errors::UNINITIALIZED_USAGE
+     *  0 - no checking at all, using an uninitialized Box is undefined behaviour
+     * The success path never allocates or formats anything. */
+#ifndef CONTAINERS_CHECK_LEVEL
+#define CONTAINERS_CHECK_LEVEL 2
+#endif
+
+#if CONTAINERS_CHECK_LEVEL >= 2
+#define CHECK_INSTANCE(instance) \
+    (__builtin_expect((instance) != NULL, 1) ? (void)0 : Containers::uninitializedUsage(__FILE__, __LINE__, __func__))
+#elif CONTAINERS_CHECK_LEVEL == 1
+#define CHECK_INSTANCE(instance) (__builtin_expect((instance) != NULL, 1) ? (void)0 : Containers::uninitializedUsage())
+#else
+#define CHECK_INSTANCE(instance) ((void)0)
+#endif
+
+    [[noreturn]] void uninitializedUsage();
+    [[noreturn]] void uninitializedUsage(const char *filename, int line, const char *function);
+
+    /** The box rules shared by Box, BoxValue and BoxStore. Each check returns the first rule broken. */
+    namespace Rules {
+
+        inline bool isValid(const Dimensions &d) {
+            return d.getLength() > 0 && d.getWidth() > 0 && d.getHeight() > 0;
+        }
+
+        inline BoxStatus checkOpen(bool isOpen) {
+            return isOpen ? BoxStatus::ALREADY_OPENED : BoxStatus::OK;
+        }
+
+        inline BoxStatus checkClose(bool isOpen, bool hasItem, int itemHeight, int height) {
+            if (!isOpen) {
+                return BoxStatus::ALREADY_CLOSED;
+            }
+            if (hasItem && itemHeight > height) {
+                return BoxStatus::ITEM_TOO_HIGH_TO_CLOSE;
+            }
+            return BoxStatus::OK;
+        }
+
+        inline BoxStatus checkPut(bool isOpen, bool hasItem, int length, int width, const Dimensions &item) {
+            if (!isValid(item)) {
+                return BoxStatus::INVALID_DIMENSIONS;
+            }
+            if (!isOpen) {
+                return BoxStatus::PUTING_TO_CLOSED;
+            }
+            if (hasItem) {
+                return BoxStatus::PUTING_TO_FULL;
+            }
+            if (length < item.getLength() || width < item.getWidth()) {
+                return BoxStatus::ITEM_DOES_NOT_FIT;
+            }
+            return BoxStatus::OK;
+        }
+
+        inline BoxStatus checkPut(bool isOpen, bool hasItem, const Dimensions &size, const Dimensions &item) {
+            return checkPut(isOpen, hasItem, size.getLength(), size.getWidth(), item);
+        }
+
+        inline BoxStatus checkTake(bool isOpen, bool hasItem) {
+            if (!isOpen) {
+                return BoxStatus::TAKING_FROM_CLOSED;
+            }
+            if (!hasItem) {
+                return BoxStatus::TAKING_FROM_EMPTY;
+            }
+            return BoxStatus::OK;
+        }
+
+        /** Throws the exception matching a failed status */
+        [[noreturn]] void throwStatus(BoxStatus status);
+
+        inline void raise(BoxStatus status) {
+            if (status != BoxStatus::OK) {
+                throwStatus(status);
+            }
+        }
+    }
+
+    namespace Serialization {
+
+        /** The fields of a Box record exactly as written, before any of the box rules are applied */
+        struct BoxRecord {
+            long long id;
+            bool isOpen, hasItem;
+            Containers::Dimensions size, item;
+        };
+
+        /** Checks a record against the box rules without building anything, the same way operator>>(std::istream &, Box &) does */
+        inline BoxStatus checkBox(const BoxRecord &record) {
+            if (!Rules::isValid(record.size)) {
+                return BoxStatus::INVALID_DIMENSIONS;
+            }
+            if (record.hasItem) {
+                BoxStatus status = Rules::checkPut(true, false, record.size, record.item);
+                if (status != BoxStatus::OK) {
+                    return status;
+                }
+            }
+            return record.isOpen ? BoxStatus::OK : Rules::checkClose(true, record.hasItem, record.item.getHeight(), record.size.getHeight());
+        }
+
+        /** Applies the box rules to a record the same way operator>>(std::istream &, Box &) does */
+        inline BoxStatus buildBox(const BoxRecord &record, BoxValue &out) {
+            BoxStatus status = checkBox(record);
+            if (status != BoxStatus::OK) {
+                return status;
+            }
+            BoxValue tmp(record.id, record.size);
+            tmp.tryOpen();
+            if (record.hasItem) {
+                tmp.tryPutItem(record.item);
+            }
+            if (!record.isOpen) {
+                tmp.tryClose();
+            }
+            out = tmp;
+            return BoxStatus::OK;
+        }
+    }
+
+    namespace Binary {
+
+        const char MAGIC[4] = {'B', 'O', 'X', 'S'};
+        const unsigned VERSION = 1;
+        const std::size_t HEADER_SIZE = 16;
+        const std::size_t RECORD_SIZE = 40;
+
+        /* Header: magic[4], version u16, flags u16, record count u64
+         * Record: id i64, flags u8, reserved[3], size i32[3], item i32[3], reserved[4] */
+        /** A TOMBSTONE record of a delta removes the box with its ID, its other fields are zero */
+        enum RecordFlag { OPEN = 1, FULL = 2, TOMBSTONE = 4 };
+
+        /** INDEXED snapshots are followed by an ID index, see BoxSnapshot. DELTA snapshots only hold changes. */
+        enum HeaderFlag { INDEXED = 1, DELTA = 2 };
+
+        struct Header {
+            unsigned version, flags;
+            unsigned long long count;
+        };
+
+        inline void put(unsigned char *out, unsigned long long value, int bytes) {
+            for (int i = 0; i < bytes; ++i) {
+                out[i] = (unsigned char)(value >> (8 * i));
+            }
+        }
+
+        inline unsigned long long get(const unsigned char *in, int bytes) {
+            unsigned long long value = 0;
+            for (int i = bytes - 1; i >= 0; --i) {
+                value = value << 8 | in[i];
+            }
+            return value;
+        }
+
+        void encodeHeader(unsigned char *out, const Header &header);
+
+        /** Returns false when in does not start with MAGIC */
+        bool decodeHeader(const unsigned char *in, Header &header);
+        void encodeRecord(unsigned char *out, const BoxValue &b);
+        void decodeRecord(const unsigned char *in, Serialization::BoxRecord &record);
+
+        /** Reads and checks a snapshot header, throwing on any problem */
+        Header readHeader(std::istream &s);
     }
 
     class Box::BoxImpl {
        private:
-        static int idCounter, instanceCounter;
-        int ID;
+        /** Instance counter split into cache line sized shards, threads count into their own shard */
+        static const int INSTANCE_SHARDS = 16;
+        struct alignas(64) CounterShard {
+            std::atomic<long long> value;
+        };
+        static CounterShard instanceCounters[INSTANCE_SHARDS];
+        static CounterShard &instanceShard();
+
+        long long ID;
         bool isOpen, hasItem;
+        /** Whether the box changed since it was last marked clean */
+        bool dirty;
         Dimensions size, item;
+        /** The ID when the box was last marked clean */
+        long long checkpointId;
 
         BoxImpl(const Dimensions &size);
+
+        /** Constructs an empty closed box with a given ID, without consuming one from the counter */
+        BoxImpl(const Dimensions &size, long long id);
         BoxImpl(const BoxImpl &b);
+        BoxImpl &operator=(const BoxImpl &b) = default;
         ~BoxImpl();
 
+        static void *operator new(std::size_t size);
+        static void operator delete(void *ptr);
+
         friend std::istream &operator>>(std::istream &s, Box &b);
         friend Box;
+        friend BoxStore;
+        friend BoxValue;
     };
 
 }
@@ -0,0 +1,321 @@
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "binary.h"
+#include "internal.h"
+#include "journal.h"
+
+namespace Containers {
+
+    /* Header: magic[4], version u16, reserved[10]
+     * Record: id i64, operation u8, reserved[3], dimensions i32[3], CRC-32 u32 of the preceding bytes */
+    static const char MAGIC[4] = {'B', 'O', 'X', 'J'};
+    static const unsigned VERSION = 1;
+    static const std::size_t HEADER_SIZE = 16;
+    static const std::size_t RECORD_SIZE = 28;
+
+    enum Operation : unsigned { CREATE = 1, OPEN, CLOSE, PUT_ITEM, TAKE_ITEM, INCREMENT };
+
+    struct Crc32Table {
+        std::uint32_t entries[256];
+
+        Crc32Table() {
+            for (std::uint32_t i = 0; i < 256; ++i) {
+                std::uint32_t c = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                entries[i] = c;
+            }
+        }
+    };
+
+    static std::uint32_t crc32(const unsigned char *data, std::size_t length) {
+        static const Crc32Table table;
+        std::uint32_t crc = 0xFFFFFFFFu;
+        for (std::size_t i = 0; i < length; ++i) {
+            crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    static bool isHeader(const unsigned char *in, std::size_t size) {
+        return size >= HEADER_SIZE && std::memcmp(in, MAGIC, 4) == 0 && Binary::get(in + 4, 2) == VERSION;
+    }
+
+    /** Returns the length of the journal up to its first torn or corrupted record */
+    static std::size_t validLength(const unsigned char *in, std::size_t size) {
+        std::size_t length = HEADER_SIZE;
+        while (size - length >= RECORD_SIZE && crc32(in + length, RECORD_SIZE - 4) == Binary::get(in + length + RECORD_SIZE - 4, 4)) {
+            length += RECORD_SIZE;
+        }
+        return length;
+    }
+
+    static void writeFully(int fd, const unsigned char *data, std::size_t size) {
+        while (size != 0) {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                throw std::runtime_error(Errors::Journal::CANNOT_WRITE + " (" + std::strerror(errno) + ")");
+            }
+            data += written;
+            size -= written;
+        }
+    }
+
+    BoxJournal::BoxJournal(const std::string &path, const JournalOptions &options)
+        : fd(-1), options(options), appended(0), durable(0), durableLength(HEADER_SIZE), flushing(false), failed(false),
+          lastSync(std::chrono::steady_clock::now()) {
+        fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+        if (fd < 0) {
+            throw std::runtime_error(Errors::CANNOT_OPEN + " (" + path + ": " + std::strerror(errno) + ")");
+        }
+        try {
+            MappedFile existing(path);
+            const unsigned char *in = reinterpret_cast<const unsigned char *>(existing.begin());
+            if (existing.size() == 0) {
+                unsigned char header[HEADER_SIZE] = {};
+                std::memcpy(header, MAGIC, 4);
+                Binary::put(header + 4, VERSION, 2);
+                writeFully(fd, header, HEADER_SIZE);
+            } else if (!isHeader(in, existing.size())) {
+                throw std::logic_error(Errors::Journal::INVALID_HEADER);
+            } else {
+                std::size_t length = validLength(in, existing.size());
+                if (length != existing.size() && ::ftruncate(fd, length) != 0) {
+                    throw std::runtime_error(Errors::Journal::CANNOT_WRITE + " (" + std::strerror(errno) + ")");
+                }
+                durableLength = length;
+            }
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+    }
+
+    BoxJournal::~BoxJournal() {
+        try {
+            commit();
+        } catch (...) {
+        }
+        ::close(fd);
+    }
+
+    void BoxJournal::append(unsigned op, long long id, const Dimensions &d) {
+        unsigned char record[RECORD_SIZE];
+        Binary::put(record, id, 8);
+        Binary::put(record + 8, op, 4);
+        Binary::put(record + 12, d.getLength(), 4);
+        Binary::put(record + 16, d.getWidth(), 4);
+        Binary::put(record + 20, d.getHeight(), 4);
+        Binary::put(record + 24, crc32(record, RECORD_SIZE - 4), 4);
+        bool full;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (failed) {
+                throw std::runtime_error(Errors::Journal::FAILED);
+            }
+            pending.insert(pending.end(), record, record + RECORD_SIZE);
+            ++appended;
+            full = pending.size() >= options.groupSize * RECORD_SIZE;
+        }
+        if (full) {
+            commit();
+        }
+    }
+
+    void BoxJournal::writeAll(const std::vector<unsigned char> &records) {
+        writeFully(fd, records.data(), records.size());
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (options.sync == SyncPolicy::COMMIT || (options.sync == SyncPolicy::PERIODIC && now - lastSync >= options.syncInterval)) {
+            if (::fdatasync(fd) != 0) {
+                throw std::runtime_error(Errors::Journal::CANNOT_WRITE + " (" + std::strerror(errno) + ")");
+            }
+            lastSync = now;
+        }
+    }
+
+    /** The first thread to commit writes the records of everyone who appended before it, the others wait */
+    void BoxJournal::commit() {
+        std::unique_lock<std::mutex> guard(lock);
+        unsigned long long target = appended;
+        while (durable < target) {
+            if (failed) {
+                throw std::runtime_error(Errors::Journal::FAILED);
+            }
+            if (flushing) {
+                flushed.wait(guard);
+                continue;
+            }
+            flushing = true;
+            std::vector<unsigned char> batch;
+            batch.swap(pending);
+            unsigned long long sequence = appended;
+            guard.unlock();
+            try {
+                writeAll(batch);
+            } catch (...) {
+                /* The batch is lost, so whatever part of it reached the file must not be followed by later records */
+                guard.lock();
+                failed = true;
+                if (::ftruncate(fd, durableLength) != 0) {
+                    /* Nothing is appended after a failure, so replay still stops at the torn record */
+                }
+                flushing = false;
+                flushed.notify_all();
+                throw;
+            }
+            guard.lock();
+            durable = sequence;
+            durableLength += batch.size();
+            flushing = false;
+            flushed.notify_all();
+        }
+    }
+
+    void BoxJournal::reset() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (flushing) {
+            flushed.wait(guard);
+        }
+        pending.clear();
+        durable = appended;
+        if (::ftruncate(fd, HEADER_SIZE) != 0 || ::fdatasync(fd) != 0) {
+            throw std::runtime_error(Errors::Journal::CANNOT_WRITE + " (" + std::strerror(errno) + ")");
+        }
+        durableLength = HEADER_SIZE;
+        failed = false;
+    }
+
+    void BoxJournal::checkFailed() {
+        std::lock_guard<std::mutex> guard(lock);
+        if (failed) {
+            throw std::runtime_error(Errors::Journal::FAILED);
+        }
+    }
+
+    Box BoxJournal::create(const Dimensions &size) {
+        checkFailed();
+        Box b(size);
+        append(CREATE, b.getId(), size);
+        return b;
+    }
+
+    void BoxJournal::open(Box &b) {
+        checkFailed();
+        Rules::raise(b.tryOpen());
+        append(OPEN, b.getId(), Dimensions());
+    }
+
+    void BoxJournal::close(Box &b) {
+        checkFailed();
+        Rules::raise(b.tryClose());
+        append(CLOSE, b.getId(), Dimensions());
+    }
+
+    void BoxJournal::putItem(Box &b, const Dimensions &item) {
+        checkFailed();
+        Rules::raise(b.tryPutItem(item));
+        append(PUT_ITEM, b.getId(), item);
+    }
+
+    Dimensions BoxJournal::takeItem(Box &b) {
+        checkFailed();
+        Dimensions item;
+        Rules::raise(b.tryTakeItem(item));
+        append(TAKE_ITEM, b.getId(), Dimensions());
+        return item;
+    }
+
+    void BoxJournal::increment(Box &b) {
+        checkFailed();
+        long long id = b.getId();
+        ++b;
+        append(INCREMENT, id, Dimensions());
+    }
+
+    std::size_t BoxJournal::replay(const std::string &path, std::vector<BoxValue> &boxes) {
+        MappedFile file(path);
+        const unsigned char *in = reinterpret_cast<const unsigned char *>(file.begin());
+        if (!isHeader(in, file.size())) {
+            throw std::logic_error(Errors::Journal::INVALID_HEADER);
+        }
+        std::size_t length = validLength(in, file.size());
+
+        std::vector<BoxValue> result(boxes);
+        std::unordered_map<long long, std::size_t> positions;
+        for (std::size_t i = 0; i < result.size(); ++i) {
+            positions[result[i].getId()] = i;
+        }
+        for (const unsigned char *record = in + HEADER_SIZE; record != in + length; record += RECORD_SIZE) {
+            long long id = Binary::get(record, 8);
+            unsigned op = record[8];
+            Dimensions d((int)Binary::get(record + 12, 4), (int)Binary::get(record + 16, 4), (int)Binary::get(record + 20, 4));
+            if (op == CREATE) {
+                if (positions.count(id) != 0) {
+                    throw std::logic_error(Errors::Journal::DUPLICATE_BOX + " (" + std::to_string(id) + ")");
+                }
+                positions[id] = result.size();
+                result.push_back(BoxValue(id, d));
+                continue;
+            }
+            std::unordered_map<long long, std::size_t>::iterator position = positions.find(id);
+            if (position == positions.end()) {
+                throw std::logic_error(Errors::Journal::UNKNOWN_BOX + " (" + std::to_string(id) + ")");
+            }
+            BoxValue &b = result[position->second];
+            Dimensions item;
+            switch (op) {
+                case OPEN:
+                    Rules::raise(b.tryOpen());
+                    break;
+                case CLOSE:
+                    Rules::raise(b.tryClose());
+                    break;
+                case PUT_ITEM:
+                    Rules::raise(b.tryPutItem(d));
+                    break;
+                case TAKE_ITEM:
+                    Rules::raise(b.tryTakeItem(item));
+                    break;
+                case INCREMENT: {
+                    if (positions.count(id + 1) != 0) {
+                        throw std::logic_error(Errors::Journal::DUPLICATE_BOX + " (" + std::to_string(id + 1) + ")");
+                    }
+                    Serialization::BoxRecord renamed = {id + 1, !b.isClosed(), b.isFull(), b.getSize(), b.isFull() ? b.getItem() : item};
+                    Rules::raise(Serialization::buildBox(renamed, b));
+                    std::size_t index = position->second;
+                    positions.erase(position);
+                    positions[id + 1] = index;
+                    break;
+                }
+                default:
+                    throw std::logic_error(Errors::Journal::UNKNOWN_OPERATION);
+            }
+        }
+        boxes.swap(result);
+        return (length - HEADER_SIZE) / RECORD_SIZE;
+    }
+
+    void BoxJournal::recover(const std::string &snapshotPath, const std::string &journalPath, std::vector<BoxValue> &boxes) {
+        std::ifstream snapshot(snapshotPath.c_str(), std::ios::binary);
+        if (!snapshot) {
+            throw std::runtime_error(Errors::CANNOT_OPEN + " (" + snapshotPath + ")");
+        }
+        std::vector<BoxValue> recovered;
+        readBinary(snapshot, recovered);
+        replay(journalPath, recovered);
+        boxes.insert(boxes.end(), recovered.begin(), recovered.end());
+    }
+}
@@ -0,0 +1,107 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "box.h"
+#include "box_value.h"
+#include "dimensions.h"
+
+namespace Containers {
+
+    /** When BoxJournal forces committed records to stable storage */
+    enum class SyncPolicy : unsigned char {
+        /** Leave it to the operating system, a crash of the process loses nothing, a crash of the machine may */
+        NONE,
+        /** Every commit waits for the disk */
+        COMMIT,
+        /** A commit waits for the disk only if the last sync is older than JournalOptions::syncInterval */
+        PERIODIC
+    };
+
+    struct JournalOptions {
+        SyncPolicy sync;
+        /** Records buffered before an operation commits them by itself */
+        std::size_t groupSize;
+        std::chrono::milliseconds syncInterval;
+
+        JournalOptions(SyncPolicy sync = SyncPolicy::COMMIT, std::size_t groupSize = 256,
+                       std::chrono::milliseconds syncInterval = std::chrono::milliseconds(100))
+            : sync(sync), groupSize(groupSize), syncInterval(syncInterval) {
+        }
+    };
+
+    /** BoxJournal is an append-only log of box state changes, used to recover the changes made after the
+     * last snapshot. Every change is a small checksummed record. Records are buffered and written in groups:
+     * commit() returns once all records appended before it are written, and threads committing at the same
+     * time share a single write and sync. The journal methods are thread-safe, the boxes passed to them are not.
+     */
+    class BoxJournal {
+       private:
+        int fd;
+        JournalOptions options;
+        std::mutex lock;
+        std::condition_variable flushed;
+        std::vector<unsigned char> pending;
+        unsigned long long appended, durable;
+        /** The length of the file up to the last record written */
+        off_t durableLength;
+        bool flushing;
+        /** Set once a write fails, the records it held are lost, so nothing more is logged until reset() */
+        bool failed;
+        std::chrono::steady_clock::time_point lastSync;
+
+        /** Throws if the journal failed, before an operation changes its box */
+        void checkFailed();
+        void append(unsigned op, long long id, const Dimensions &d);
+        void writeAll(const std::vector<unsigned char> &records);
+
+       public:
+        /** Opens the journal at path, creating it if needed. A torn record left by a crash at the end of
+         * an existing journal is cut off. */
+        explicit BoxJournal(const std::string &path, const JournalOptions &options = JournalOptions());
+        BoxJournal(const BoxJournal &j) = delete;
+        BoxJournal &operator=(const BoxJournal &j) = delete;
+
+        /** Commits the remaining records, errors are ignored */
+        ~BoxJournal();
+
+        /* Apply an operation to a box like the Box method of the same name does, logging it on success */
+        Box create(const Dimensions &size);
+        void open(Box &b);
+        void close(Box &b);
+        void putItem(Box &b, const Dimensions &item);
+        Dimensions takeItem(Box &b);
+        /** Logs ++b */
+        void increment(Box &b);
+
+        /** Writes every record appended so far, syncing as the policy says. If the write fails, the partly written
+         * records are cut off the file and the journal fails: every later operation throws, leaving its box
+         * unchanged, until reset(). */
+        void commit();
+
+        /** Empties the journal, to be called once a snapshot holding every logged change is safely written.
+         * This also clears a failure. */
+        void reset();
+
+        /** Applies the records of the journal at path to boxes, which hold the snapshot it continues.
+         * Replay stops at the first torn or corrupted record. A record creating or incrementing a box to an ID
+         * already in use, as IDs start over in every process, throws std::logic_error.
+         * @return the number of records applied
+         */
+        static std::size_t replay(const std::string &path, std::vector<BoxValue> &boxes);
+
+        /** Reads a snapshot written by writeBinary() and replays the journal over it */
+        static void recover(const std::string &snapshotPath, const std::string &journalPath, std::vector<BoxValue> &boxes);
+    };
+
+}
+
+#endif /* JOURNAL_H */
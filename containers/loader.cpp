@@ -0,0 +1,289 @@
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <thread>
+
+#include "cursor.h"
+#include "loader.h"
+
+namespace Containers {
+
+    /** Chunks smaller than this are not worth a thread */
+    static const std::size_t MIN_CHUNK_SIZE = 1 << 16;
+
+    /** More chunks than threads even out chunks which parse slower than others */
+    static const std::size_t CHUNKS_PER_THREAD = 4;
+
+    static unsigned threadCount(unsigned threads) {
+        if (threads == 0) {
+            threads = std::thread::hardware_concurrency();
+        }
+        return std::max(threads, 1u);
+    }
+
+    /** Splits the text into chunks which start at a box, returning the chunk boundaries */
+    static std::vector<const char *> splitChunks(const char *begin, const char *end, unsigned threads) {
+        std::size_t size = end - begin;
+        std::size_t count = std::max<std::size_t>(1, std::min(threads * CHUNKS_PER_THREAD, size / MIN_CHUNK_SIZE));
+        std::vector<const char *> bounds(1, begin);
+        for (std::size_t i = 1; i < count; ++i) {
+            const char *split = Serialization::nextRecordStart(begin, std::max(begin + size / count * i, bounds.back()), end);
+            if (split != bounds.back() && split != end) {
+                bounds.push_back(split);
+            }
+        }
+        bounds.push_back(end);
+        return bounds;
+    }
+
+    /** Calls task(chunk) for every chunk, spreading the chunks over the threads */
+    template <class Task>
+    static void runChunks(std::size_t chunks, unsigned threads, Task task) {
+        std::atomic<std::size_t> next(0);
+        auto work = [&next, chunks, &task] {
+            for (std::size_t chunk = next++; chunk < chunks; chunk = next++) {
+                task(chunk);
+            }
+        };
+        std::vector<std::thread> workers;
+        for (std::size_t t = 1; t < std::min<std::size_t>(threads, chunks); ++t) {
+            workers.push_back(std::thread(work));
+        }
+        work();
+        for (std::size_t t = 0; t < workers.size(); ++t) {
+            workers[t].join();
+        }
+    }
+
+    template <class T>
+    struct ChunkResult {
+        std::vector<T> boxes;
+        ParseResult error;
+        const char *errorAt;
+        /** Where the last record ended if it ran past the chunk, the chunks after it are parsed again from there */
+        const char *overrun;
+    };
+
+    /** Parses records up to the end of the chunk, stopping at the first error.
+     * parse(position, end, boxes) reads one record, appending it to boxes if it is kept. */
+    template <class T, class Parse>
+    static void parseChunk(const char *position, const char *end, const char *textEnd, ChunkResult<T> &result, const Parse &parse) {
+        result.error.error = ParseError::NONE;
+        result.overrun = NULL;
+        for (;;) {
+            while (position != end && Serialization::isSpace(*position)) {
+                ++position;
+            }
+            if (position == end) {
+                return;
+            }
+            ParseResult r = parse(position, end, result.boxes);
+            if (!r.ok() && end != textEnd) {
+                /* The record may cross the chunk end, only the whole text tells its real error, if any */
+                r = parse(position, textEnd, result.boxes);
+                if (r.ok()) {
+                    result.overrun = position + r.position;
+                    return;
+                }
+            }
+            if (!r.ok()) {
+                result.error = r;
+                result.errorAt = position + r.position;
+                return;
+            }
+            position += r.position;
+        }
+    }
+
+    template <class T, class Parse>
+    static void load(const char *begin, const char *end, std::vector<T> &out, unsigned threads, const Parse &parse) {
+        threads = threadCount(threads);
+        std::vector<const char *> bounds = splitChunks(begin, end, threads);
+        std::vector<ChunkResult<T> > results(bounds.size() - 1);
+        runChunks(results.size(), threads, [&bounds, &results, &parse, end](std::size_t chunk) {
+            parseChunk(bounds[chunk], bounds[chunk + 1], end, results[chunk], parse);
+        });
+
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const ChunkResult<T> &r = results[i];
+            if (!r.error.ok()) {
+                Serialization::raiseParseError(r.error, 1 + std::count(begin, r.errorAt, '\n'), r.errorAt - begin);
+            }
+            total += r.boxes.size();
+            if (r.overrun != NULL) {
+                /* The chunks after it did not start at a record, the rest of the text is read like the sequential reader does */
+                results.resize(i + 2);
+                results[i + 1].boxes.clear();
+                parseChunk(r.overrun, end, end, results[i + 1], parse);
+            }
+        }
+        out.reserve(out.size() + total);
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            out.insert(out.end(), std::make_move_iterator(results[i].boxes.begin()), std::make_move_iterator(results[i].boxes.end()));
+        }
+    }
+
+    template <class T>
+    static void load(const char *begin, const char *end, std::vector<T> &out, unsigned threads) {
+        load(begin, end, out, threads, [](const char *position, const char *end, std::vector<T> &boxes) {
+            boxes.emplace_back();
+            ParseResult r = parseBox(position, end, boxes.back());
+            if (!r.ok()) {
+                boxes.pop_back();
+            }
+            return r;
+        });
+    }
+
+    /** Reads one record of a query, checking the rules of the read fields if the filter keeps it */
+    static ParseResult parseSelected(const char *begin, const char *end, const BoxQuery &query, unsigned skip, std::vector<BoxFields> &boxes) {
+        Serialization::Cursor cursor(begin, end);
+        Serialization::BoxRecord record;
+        ParseResult r;
+        r.status = BoxStatus::OK;
+        if (!cursor.readBoxRecord(record, skip)) {
+            r.error = cursor.error;
+            r.position = cursor.offset();
+            return r;
+        }
+        r.error = ParseError::NONE;
+        r.position = cursor.offset();
+        BoxFields fields = {record.id, record.isOpen, record.hasItem, record.size, record.item};
+        if (query.filter && !query.filter(fields)) {
+            return r;
+        }
+        const unsigned rules = BoxQuery::IS_OPEN | BoxQuery::SIZE | BoxQuery::ITEM;
+        if ((query.fields & rules) == rules) {
+            r.status = Serialization::checkBox(record);
+        } else {
+            if (query.fields & BoxQuery::SIZE) {
+                r.status = Rules::isValid(record.size) ? BoxStatus::OK : BoxStatus::INVALID_DIMENSIONS;
+            }
+            if (r.status == BoxStatus::OK && (query.fields & BoxQuery::ITEM) && record.hasItem) {
+                if (query.fields & BoxQuery::SIZE) {
+                    r.status = Rules::checkPut(true, false, record.size, record.item);
+                } else {
+                    r.status = Rules::isValid(record.item) ? BoxStatus::OK : BoxStatus::INVALID_DIMENSIONS;
+                }
+            }
+        }
+        if (r.status != BoxStatus::OK) {
+            r.error = ParseError::INVALID_BOX;
+            r.position = 0;
+            return r;
+        }
+        boxes.push_back(fields);
+        return r;
+    }
+
+    static void select(const char *begin, const char *end, const BoxQuery &query, std::vector<BoxFields> &out, unsigned threads) {
+        using Serialization::Field;
+        const unsigned skip = (query.fields & BoxQuery::ID ? 0 : 1u << static_cast<unsigned>(Field::ID)) |
+                              (query.fields & BoxQuery::IS_OPEN ? 0 : 1u << static_cast<unsigned>(Field::IS_OPEN)) |
+                              (query.fields & BoxQuery::SIZE ? 0 : 1u << static_cast<unsigned>(Field::SIZE)) |
+                              (query.fields & BoxQuery::ITEM ? 0 : 1u << static_cast<unsigned>(Field::ITEM));
+        load(begin, end, out, threads, [&query, skip](const char *position, const char *end, std::vector<BoxFields> &boxes) {
+            return parseSelected(position, end, query, skip, boxes);
+        });
+    }
+
+    struct ValidationChunk {
+        std::size_t boxes;
+        std::vector<ReadError> errors;
+    };
+
+    /** Checks every record of the chunk, moving to the next box after an error */
+    static void validateChunk(const char *begin, const char *position, const char *end, ValidationChunk &result) {
+        const char *chunk = position;
+        result.boxes = 0;
+        for (;;) {
+            while (position != end && Serialization::isSpace(*position)) {
+                ++position;
+            }
+            if (position == end) {
+                return;
+            }
+            Serialization::Cursor cursor(position, end);
+            Serialization::BoxRecord record;
+            ReadError error;
+            error.result.status = BoxStatus::OK;
+            if (!cursor.readBoxRecord(record)) {
+                error.result.error = cursor.error;
+                error.offset = cursor.position - begin;
+            } else if ((error.result.status = Serialization::checkBox(record)) != BoxStatus::OK) {
+                error.result.error = ParseError::INVALID_BOX;
+                error.offset = position - begin;
+            } else {
+                ++result.boxes;
+                position = cursor.position;
+                continue;
+            }
+            error.result.position = error.offset;
+            error.line = 0;
+            result.errors.push_back(error);
+            position = Serialization::nextRecordStart(chunk, position + 1, end);
+        }
+    }
+
+    static ValidationReport validate(const char *begin, const char *end, unsigned threads) {
+        threads = threadCount(threads);
+        std::vector<const char *> bounds = splitChunks(begin, end, threads);
+        std::vector<ValidationChunk> results(bounds.size() - 1);
+        runChunks(results.size(), threads, [begin, &bounds, &results](std::size_t chunk) {
+            validateChunk(begin, bounds[chunk], bounds[chunk + 1], results[chunk]);
+        });
+
+        ValidationReport report;
+        report.boxes = 0;
+        const char *counted = begin;
+        unsigned long long line = 1;
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            report.boxes += results[i].boxes;
+            for (std::size_t e = 0; e < results[i].errors.size(); ++e) {
+                ReadError error = results[i].errors[e];
+                line += std::count(counted, begin + error.offset, '\n');
+                counted = begin + error.offset;
+                error.line = line;
+                report.errors.push_back(error);
+            }
+        }
+        return report;
+    }
+
+    ValidationReport validateBoxes(const char *begin, const char *end, unsigned threads) {
+        return validate(begin, end, threads);
+    }
+
+    ValidationReport validateBoxes(const std::string &path, unsigned threads) {
+        MappedFile file(path);
+        return validate(file.begin(), file.end(), threads);
+    }
+
+    void loadBoxes(const char *begin, const char *end, std::vector<BoxValue> &out, unsigned threads) {
+        load(begin, end, out, threads);
+    }
+
+    void loadBoxes(const char *begin, const char *end, std::vector<Box> &out, unsigned threads) {
+        load(begin, end, out, threads);
+    }
+
+    void loadBoxes(const std::string &path, std::vector<BoxValue> &out, unsigned threads) {
+        MappedFile file(path);
+        load(file.begin(), file.end(), out, threads);
+    }
+
+    void loadBoxes(const std::string &path, std::vector<Box> &out, unsigned threads) {
+        MappedFile file(path);
+        load(file.begin(), file.end(), out, threads);
+    }
+
+    void selectBoxes(const char *begin, const char *end, const BoxQuery &query, std::vector<BoxFields> &out, unsigned threads) {
+        select(begin, end, query, out, threads);
+    }
+
+    void selectBoxes(const std::string &path, const BoxQuery &query, std::vector<BoxFields> &out, unsigned threads) {
+        MappedFile file(path);
+        select(file.begin(), file.end(), query, out, threads);
+    }
+}
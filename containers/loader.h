@@ -0,0 +1,73 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "box.h"
+#include "box_value.h"
+#include "dimensions.h"
+#include "reader.h"
+
+namespace Containers {
+
+    /* Parse boxes in the toString() format from a buffer or a file on several threads and append them to out
+     * in input order. The input is split into chunks starting at a box, each of them parsed by one thread.
+     * threads = 0 uses one thread per hardware thread.
+     * Errors are thrown like BoxReader throws them, the first one in the input wins and out is left unchanged. */
+    void loadBoxes(const char *begin, const char *end, std::vector<BoxValue> &out, unsigned threads = 0);
+    void loadBoxes(const char *begin, const char *end, std::vector<Box> &out, unsigned threads = 0);
+    void loadBoxes(const std::string &path, std::vector<BoxValue> &out, unsigned threads = 0);
+    void loadBoxes(const std::string &path, std::vector<Box> &out, unsigned threads = 0);
+
+    /** Outcome of validateBoxes() */
+    struct ValidationReport {
+        /** Number of valid boxes */
+        std::size_t boxes;
+        /** The first error of every invalid record, in input order. ParseResult::position equals the offset. */
+        std::vector<ReadError> errors;
+
+        bool ok() const {
+            return errors.empty();
+        }
+    };
+
+    /* Check text for loadBoxes() in parallel without building anything. The grammar and every box rule are
+     * checked, after an invalid record checking goes on from the next box like BoxReader does when skipping. */
+    ValidationReport validateBoxes(const char *begin, const char *end, unsigned threads = 0);
+    ValidationReport validateBoxes(const std::string &path, unsigned threads = 0);
+
+    /** A box record as read by selectBoxes(), the fields which were not read are left zero */
+    struct BoxFields {
+        long long id;
+        bool isOpen;
+        /** Set whether or not the item itself is read */
+        bool hasItem;
+        Dimensions size, item;
+    };
+
+    /** Tells selectBoxes() which fields of a record to read and which records to keep */
+    struct BoxQuery {
+        enum Field : unsigned { ID = 1, IS_OPEN = 2, SIZE = 4, ITEM = 8, ALL = 15 };
+
+        /** Fields to read, the others are skipped without being parsed */
+        unsigned fields;
+
+        /** Keeps the records it returns true for, seeing only the read fields. It is called from several
+         * threads at once. An empty filter keeps every record. */
+        std::function<bool(const BoxFields &)> filter;
+
+        BoxQuery(unsigned fields = ALL, std::function<bool(const BoxFields &)> filter = nullptr) : fields(fields), filter(filter) {
+        }
+    };
+
+    /* Load the records matching a query in parallel, like loadBoxes(). The filter runs while parsing, so
+     * rejected records cost no more than a scan. Kept records are checked against the box rules involving
+     * the read fields, rejected ones only against the grammar. */
+    void selectBoxes(const char *begin, const char *end, const BoxQuery &query, std::vector<BoxFields> &out, unsigned threads = 0);
+    void selectBoxes(const std::string &path, const BoxQuery &query, std::vector<BoxFields> &out, unsigned threads = 0);
+
+}
+
+#endif /* LOADER_H */
@@ -0,0 +1,44 @@
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "internal.h"
+
+namespace Containers {
+
+    MappedFile::MappedFile(const std::string &path) : data(NULL), length(0) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error(Errors::CANNOT_OPEN + " (" + path + ": " + std::strerror(errno) + ")");
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::runtime_error(Errors::CANNOT_OPEN + " (" + path + ": " + std::strerror(error) + ")");
+        }
+        length = info.st_size;
+        if (length == 0) {
+            ::close(fd);
+            return;
+        }
+        void *mapping = ::mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+        int error = errno;
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error(Errors::CANNOT_OPEN + " (" + path + ": " + std::strerror(error) + ")");
+        }
+        data = static_cast<const char *>(mapping);
+    }
+
+    MappedFile::~MappedFile() {
+        if (data != NULL) {
+            ::munmap(const_cast<char *>(data), length);
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#include <stdexcept>
+
+#include "cursor.h"
+#include "parser.h"
+
+namespace Containers {
+
+    using Serialization::Cursor;
+
+    static ParseResult result(ParseError error, BoxStatus status, std::size_t position) {
+        ParseResult r;
+        r.error = error;
+        r.status = status;
+        r.position = position;
+        return r;
+    }
+
+    const std::string &describe(const ParseResult &result) {
+        static const string NONE;
+        switch (result.error) {
+            case ParseError::NONE:
+                return NONE;
+            case ParseError::UNEXPECTED_END:
+                return Errors::UNEXPECTED_END;
+            case ParseError::INVALID_SYMBOL:
+                return Errors::INVALID_SYMBOL;
+            case ParseError::UNKNOWN_VALUE:
+                return Errors::UNKNOWN_VALUE;
+            case ParseError::INVALID_NUMBER:
+                return Errors::INVALID_NUMBER;
+            case ParseError::INVALID_BOX:
+                return describe(result.status);
+        }
+        return NONE;
+    }
+
+    void Serialization::raiseParseError(const ParseResult &result, unsigned long long line, unsigned long long offset) {
+        string where = " (line " + std::to_string(line) + ", byte " + std::to_string(offset) + ")";
+        if (result.error == ParseError::INVALID_BOX && result.status == BoxStatus::INVALID_DIMENSIONS) {
+            throw std::invalid_argument(describe(result) + where);
+        }
+        throw std::logic_error(describe(result) + where);
+    }
+
+    ParseResult parseDimensions(const char *begin, const char *end, Dimensions &out) {
+        Cursor cursor(begin, end);
+        if (!cursor.readDimensions(out)) {
+            return result(cursor.error, BoxStatus::OK, cursor.offset());
+        }
+        return result(ParseError::NONE, BoxStatus::OK, cursor.offset());
+    }
+
+    ParseResult parseBox(const char *begin, const char *end, BoxValue &out) {
+        Cursor cursor(begin, end);
+        Serialization::BoxRecord record;
+        if (!cursor.skipSpace()) {
+            return result(cursor.error, BoxStatus::OK, cursor.offset());
+        }
+        std::size_t start = cursor.offset();
+        if (!cursor.readBoxRecord(record)) {
+            return result(cursor.error, BoxStatus::OK, cursor.offset());
+        }
+        BoxStatus status = Serialization::buildBox(record, out);
+        if (status != BoxStatus::OK) {
+            return result(ParseError::INVALID_BOX, status, start);
+        }
+        return result(ParseError::NONE, BoxStatus::OK, cursor.offset());
+    }
+
+    ParseResult parseBox(const char *begin, const char *end, Box &out) {
+        BoxValue value;
+        ParseResult r = parseBox(begin, end, value);
+        if (r.ok()) {
+            value.assignTo(out);
+        }
+        return r;
+    }
+}
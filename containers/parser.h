@@ -0,0 +1,52 @@
+#ifndef PARSER_H
+#define PARSER_H
+
+#include <cstddef>
+#include <string>
+
+#include "box.h"
+#include "box_value.h"
+#include "dimensions.h"
+
+namespace Containers {
+
+    /** Reasons why the text format could not be parsed */
+    enum class ParseError : unsigned char {
+        NONE,
+        /** The input ended in the middle of a value, more input may complete it */
+        UNEXPECTED_END,
+        INVALID_SYMBOL,
+        UNKNOWN_VALUE,
+        INVALID_NUMBER,
+        /** The value is well formed, but the box breaks one of its rules, see ParseResult::status */
+        INVALID_BOX
+    };
+
+    struct ParseResult {
+        ParseError error;
+        /** The broken rule when error is ParseError::INVALID_BOX */
+        BoxStatus status;
+        /** Offset of the offending character (of the opening mark for ParseError::INVALID_BOX),
+         * or just past the parsed value on success */
+        std::size_t position;
+
+        bool ok() const {
+            return error == ParseError::NONE;
+        }
+    };
+
+    /** Returns the message describing a failed parse result */
+    const std::string &describe(const ParseResult &result);
+
+    /* Parsers of the toString() format working directly on a character buffer. They accept exactly what
+     * the stream operators accept and never throw. The output is only modified on success.
+     * Leading whitespace is skipped, parsing stops right after the closing mark. */
+    ParseResult parseDimensions(const char *begin, const char *end, Dimensions &out);
+    ParseResult parseBox(const char *begin, const char *end, BoxValue &out);
+
+    /** Parses straight into an existing Box. Nothing is allocated unless out is uninitialized. */
+    ParseResult parseBox(const char *begin, const char *end, Box &out);
+
+}
+
+#endif /* PARSER_H */
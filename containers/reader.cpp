@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "cursor.h"
+#include "reader.h"
+
+namespace Containers {
+
+    BoxReader::BoxReader(std::istream &input, bool skipInvalid, std::size_t bufferSize)
+        : input(input), buffer(std::max(bufferSize, Serialization::MAX_BOX_TEXT)), position(0), end(0), offset(0), line(1),
+          skipInvalid(skipInvalid), exhausted(false), skipped(0) {
+        error.result.error = ParseError::NONE;
+        error.result.status = BoxStatus::OK;
+        error.result.position = 0;
+        error.offset = 0;
+        error.line = 0;
+    }
+
+    void BoxReader::advance(std::size_t count) {
+        line += std::count(buffer.data() + position, buffer.data() + position + count, '\n');
+        position += count;
+        offset += count;
+    }
+
+    /** Moves the unread characters to the front of the buffer and reads more after them */
+    bool BoxReader::refill() {
+        if (exhausted) {
+            return false;
+        }
+        if (position != 0) {
+            std::memmove(buffer.data(), buffer.data() + position, end - position);
+            end -= position;
+            position = 0;
+        }
+        input.read(buffer.data() + end, buffer.size() - end);
+        std::size_t read = input.gcount();
+        end += read;
+        exhausted = !input;
+        return read != 0;
+    }
+
+    void BoxReader::skipSpace() {
+        std::size_t start = position;
+        while (position != end && Serialization::isSpace(buffer[position])) {
+            ++position;
+        }
+        std::size_t count = position - start;
+        position = start;
+        advance(count);
+    }
+
+    /** Drops characters up to the next BEGIN_MARK which starts a box rather than a value */
+    void BoxReader::resynchronize() {
+        char previous = buffer[position];
+        advance(1);
+        do {
+            std::size_t start = position, scan = position;
+            while (scan != end && (buffer[scan] != Serialization::BEGIN_MARK || previous == Serialization::VALUE_MARK)) {
+                if (!Serialization::isSpace(buffer[scan])) {
+                    previous = buffer[scan];
+                }
+                ++scan;
+            }
+            position = start;
+            advance(scan - start);
+            if (scan != end) {
+                return;
+            }
+        } while (refill());
+    }
+
+    void BoxReader::fail(const ParseResult &result, std::size_t at) {
+        error.result = result;
+        error.offset = offset + (at - position);
+        error.line = line + std::count(buffer.data() + position, buffer.data() + at, '\n');
+        if (skipInvalid) {
+            ++skipped;
+            resynchronize();
+            return;
+        }
+        Serialization::raiseParseError(result, error.line, error.offset);
+    }
+
+    bool BoxReader::next(BoxValue &out) {
+        for (;;) {
+            skipSpace();
+            if (position == end) {
+                if (!refill()) {
+                    return false;
+                }
+                continue;
+            }
+            ParseResult result = parseBox(buffer.data() + position, buffer.data() + end, out);
+            if (result.ok()) {
+                advance(result.position);
+                return true;
+            }
+            if (result.error == ParseError::UNEXPECTED_END && !exhausted) {
+                if (position == 0 && end == buffer.size()) {
+                    throw std::logic_error(Errors::Reader::RECORD_TOO_LONG + " (line " + std::to_string(line) + ", byte " +
+                                           std::to_string(offset) + ")");
+                }
+                refill();
+                continue;
+            }
+            fail(result, position + result.position);
+        }
+    }
+
+    bool BoxReader::next(Box &out) {
+        BoxValue value;
+        if (!next(value)) {
+            return false;
+        }
+        value.assignTo(out);
+        return true;
+    }
+
+    unsigned long long BoxReader::getOffset() const {
+        return offset;
+    }
+
+    unsigned long long BoxReader::getLine() const {
+        return line;
+    }
+
+    std::size_t BoxReader::getSkipped() const {
+        return skipped;
+    }
+
+    const ReadError &BoxReader::getLastError() const {
+        return error;
+    }
+}
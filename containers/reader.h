@@ -0,0 +1,70 @@
+#ifndef READER_H
+#define READER_H
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+#include "box.h"
+#include "box_value.h"
+#include "parser.h"
+
+namespace Containers {
+
+    /** Where and why BoxReader failed to read a record */
+    struct ReadError {
+        ParseResult result;
+        /** Byte offset of the offending character from the start of the input */
+        unsigned long long offset;
+        /** Line of the offending character, starting from 1 */
+        unsigned long long line;
+    };
+
+    /** BoxReader reads boxes in the toString() format one after another from a stream of any size.
+     * Input goes through a fixed buffer which is refilled as records are consumed, so memory use does not
+     * depend on the length of the input. A single record must fit in the buffer.
+     */
+    class BoxReader {
+       private:
+        std::istream &input;
+        std::vector<char> buffer;
+        std::size_t position, end;
+        unsigned long long offset, line;
+        bool skipInvalid, exhausted;
+        std::size_t skipped;
+        ReadError error;
+
+        void advance(std::size_t count);
+        bool refill();
+        void skipSpace();
+        void resynchronize();
+        void fail(const ParseResult &result, std::size_t at);
+
+       public:
+        static const std::size_t DEFAULT_BUFFER_SIZE = 1 << 16;
+
+        /** @param skipInvalid when set, records which cannot be read are skipped instead of throwing
+         * @param bufferSize the buffer size, which limits the length of a single record
+         */
+        explicit BoxReader(std::istream &input, bool skipInvalid = false, std::size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+        /** Reads the next box, following the same rules as operator>>.
+         * Errors are thrown with their line and byte offset, unless skipping was requested.
+         * A record longer than the buffer is always thrown.
+         * @return false when the input has no more boxes
+         */
+        bool next(BoxValue &out);
+        bool next(Box &out);
+
+        /** Byte offset and line of the next unread character */
+        unsigned long long getOffset() const;
+        unsigned long long getLine() const;
+
+        /** Number of records skipped so far, and the error of the last one of them */
+        std::size_t getSkipped() const;
+        const ReadError &getLastError() const;
+    };
+
+}
+
+#endif /* READER_H */
@@ -0,0 +1,347 @@
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CONTAINERS_X86 1
+#endif
+
+#include "cursor.h"
+#include "scanner.h"
+
+namespace Containers {
+
+    using Serialization::Field;
+
+    /** The longest text a structural index can address */
+    static const std::uint64_t MAX_INDEXED = std::numeric_limits<std::uint32_t>::max();
+
+    static bool isStructural(char c) {
+        return c == Serialization::BEGIN_MARK || c == Serialization::END_MARK || c == Serialization::VALUE_MARK ||
+               c == Serialization::VALUE_SEPARATOR;
+    }
+
+    /** Appends the offsets of the bits set in mask, the bit i standing for the character at base + i */
+    static inline void flatten(std::vector<std::uint32_t> &index, std::uint32_t base, std::uint64_t mask) {
+        std::size_t size = index.size();
+        index.resize(size + __builtin_popcountll(mask));
+        for (std::uint32_t *out = index.data() + size; mask != 0; mask &= mask - 1) {
+            *out++ = base + __builtin_ctzll(mask);
+        }
+    }
+
+    static void scanScalar(const char *begin, const char *position, const char *end, std::vector<std::uint32_t> &index) {
+        for (; position != end; ++position) {
+            if (isStructural(*position)) {
+                index.push_back(position - begin);
+            }
+        }
+    }
+
+#ifdef CONTAINERS_X86
+    __attribute__((target("sse2"))) static inline __m128i matchSse2(const char *p) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i braces = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(Serialization::BEGIN_MARK)),
+                                      _mm_cmpeq_epi8(v, _mm_set1_epi8(Serialization::END_MARK)));
+        __m128i marks = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(Serialization::VALUE_MARK)),
+                                     _mm_cmpeq_epi8(v, _mm_set1_epi8(Serialization::VALUE_SEPARATOR)));
+        return _mm_or_si128(braces, marks);
+    }
+
+    __attribute__((target("sse2"))) static void scanSse2(const char *begin, const char *end, std::vector<std::uint32_t> &index) {
+        const char *p = begin;
+        for (; end - p >= 64; p += 64) {
+            std::uint64_t mask = 0;
+            for (int i = 0; i < 4; ++i) {
+                mask |= std::uint64_t(unsigned(_mm_movemask_epi8(matchSse2(p + 16 * i)))) << (16 * i);
+            }
+            flatten(index, p - begin, mask);
+        }
+        scanScalar(begin, p, end, index);
+    }
+
+    __attribute__((target("avx2"))) static inline __m256i matchAvx2(const char *p) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i braces = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(Serialization::BEGIN_MARK)),
+                                         _mm256_cmpeq_epi8(v, _mm256_set1_epi8(Serialization::END_MARK)));
+        __m256i marks = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(Serialization::VALUE_MARK)),
+                                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8(Serialization::VALUE_SEPARATOR)));
+        return _mm256_or_si256(braces, marks);
+    }
+
+    __attribute__((target("avx2"))) static void scanAvx2(const char *begin, const char *end, std::vector<std::uint32_t> &index) {
+        const char *p = begin;
+        for (; end - p >= 64; p += 64) {
+            std::uint64_t low = unsigned(_mm256_movemask_epi8(matchAvx2(p)));
+            std::uint64_t high = unsigned(_mm256_movemask_epi8(matchAvx2(p + 32)));
+            flatten(index, p - begin, low | high << 32);
+        }
+        scanScalar(begin, p, end, index);
+    }
+#endif
+
+    ScanLevel detectScanLevel() {
+#ifdef CONTAINERS_X86
+        static const ScanLevel level = __builtin_cpu_supports("avx2")   ? ScanLevel::AVX2
+                                       : __builtin_cpu_supports("sse2") ? ScanLevel::SSE2
+                                                                        : ScanLevel::SCALAR;
+        return level;
+#else
+        return ScanLevel::SCALAR;
+#endif
+    }
+
+    void scanStructure(const char *begin, const char *end, std::vector<std::uint32_t> &index, ScanLevel level) {
+        if ((std::uint64_t)(end - begin) > MAX_INDEXED) {
+            throw std::invalid_argument(Errors::Scanner::TOO_LARGE);
+        }
+        if (level > detectScanLevel()) {
+            level = detectScanLevel();
+        }
+        index.reserve(index.size() + (end - begin) / 4);
+        switch (level) {
+#ifdef CONTAINERS_X86
+            case ScanLevel::AVX2:
+                scanAvx2(begin, end, index);
+                return;
+            case ScanLevel::SSE2:
+                scanSse2(begin, end, index);
+                return;
+#endif
+            default:
+                scanScalar(begin, begin, end, index);
+        }
+    }
+
+    /** Parses boxes by walking the structural index. Tokens are the trimmed text between two structural
+     * characters. Anything unusual makes a read fail, the caller then parses the box again with the Cursor,
+     * which knows the exact error, so only the common well formed case needs to be handled here. */
+    class IndexedParser {
+       public:
+        const char *text, *end;
+        const std::uint32_t *structural, *structuralEnd;
+        /** Everything before consumed has been parsed */
+        const char *consumed;
+
+        IndexedParser(const char *text, const char *end, const std::vector<std::uint32_t> &index)
+            : text(text), end(end), structural(index.data()), structuralEnd(index.data() + index.size()), consumed(text) {
+        }
+
+        static bool isBlank(const char *begin, const char *end) {
+            for (; begin != end; ++begin) {
+                if (!Serialization::isSpace(*begin)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        static void trim(const char *&begin, const char *&end) {
+            while (begin != end && Serialization::isSpace(*begin)) {
+                ++begin;
+            }
+            while (begin != end && Serialization::isSpace(end[-1])) {
+                --end;
+            }
+        }
+
+        /** Takes the next structural character, which must be mark and be preceded only by whitespace */
+        bool take(char mark) {
+            if (structural == structuralEnd) {
+                return false;
+            }
+            const char *p = text + *structural;
+            if (*p != mark || !isBlank(consumed, p)) {
+                return false;
+            }
+            ++structural;
+            consumed = p + 1;
+            return true;
+        }
+
+        /** Takes VALUE_SEPARATOR or END_MARK after the already consumed value */
+        bool takeSeparator(bool &more) {
+            more = structural != structuralEnd && text[*structural] == Serialization::VALUE_SEPARATOR;
+            return take(more ? Serialization::VALUE_SEPARATOR : Serialization::END_MARK);
+        }
+
+        /** Takes a field name with its VALUE_MARK. Like Cursor::readValueName, a name glued to the mark
+         * must be followed by whitespace. Known names contain no whitespace, so matching one is enough. */
+        bool takeName(Field &field) {
+            if (structural == structuralEnd || text[*structural] != Serialization::VALUE_MARK) {
+                return false;
+            }
+            const char *name = consumed, *mark = text + *structural, *nameEnd = mark;
+            trim(name, nameEnd);
+            if (name == nameEnd || (nameEnd == mark && (mark + 1 == end || !Serialization::isSpace(mark[1])))) {
+                return false;
+            }
+            field = Serialization::Cursor::fieldOf(name, nameEnd - name);
+            ++structural;
+            consumed = mark + 1;
+            return field != Field::UNKNOWN;
+        }
+
+        /** Returns the trimmed text up to the next structural character, which is not consumed */
+        bool takeToken(const char *&begin, const char *&tokenEnd) {
+            if (structural == structuralEnd) {
+                return false;
+            }
+            begin = consumed;
+            tokenEnd = text + *structural;
+            trim(begin, tokenEnd);
+            consumed = text + *structural;
+            return begin != tokenEnd;
+        }
+
+        bool takeNumber(long long &value, long long min, long long max) {
+            const char *p, *tokenEnd;
+            if (!takeToken(p, tokenEnd)) {
+                return false;
+            }
+            bool negative = false;
+            if (*p == '-' || *p == '+') {
+                negative = *p++ == '-';
+            }
+            if (p == tokenEnd) {
+                return false;
+            }
+            unsigned long long magnitude = 0, limit = negative ? 0ULL - (unsigned long long)min : (unsigned long long)max;
+            for (; p != tokenEnd; ++p) {
+                unsigned digit = *p - '0';
+                if (digit > 9 || magnitude > (limit - digit) / 10) {
+                    return false;
+                }
+                magnitude = magnitude * 10 + digit;
+            }
+            value = negative ? (long long)(0ULL - magnitude) : (long long)magnitude;
+            return true;
+        }
+
+        bool takeInt(int &value) {
+            long long tmp;
+            if (!takeNumber(tmp, -2147483647LL - 1, 2147483647LL)) {
+                return false;
+            }
+            value = (int)tmp;
+            return true;
+        }
+
+        bool takeBool(bool &value) {
+            const char *p, *tokenEnd;
+            if (!takeToken(p, tokenEnd)) {
+                return false;
+            }
+            value = Serialization::Cursor::matches(p, tokenEnd - p, Serialization::TRUE);
+            return value || Serialization::Cursor::matches(p, tokenEnd - p, Serialization::FALSE);
+        }
+
+        bool takeDimensions(Containers::Dimensions &d) {
+            int length = 0, width = 0, height = 0;
+            bool more;
+            if (!take(Serialization::BEGIN_MARK)) {
+                return false;
+            }
+            do {
+                Field field;
+                if (!takeName(field)) {
+                    return false;
+                }
+                bool read;
+                if (field == Field::LENGTH) {
+                    read = takeInt(length);
+                } else if (field == Field::WIDTH) {
+                    read = takeInt(width);
+                } else if (field == Field::HEIGHT) {
+                    read = takeInt(height);
+                } else {
+                    return false;
+                }
+                if (!read || !takeSeparator(more)) {
+                    return false;
+                }
+            } while (more);
+            d = Containers::Dimensions(length, width, height);
+            return true;
+        }
+
+        bool takeBox(BoxValue &out) {
+            Serialization::BoxRecord record;
+            record.id = 0;
+            record.isOpen = record.hasItem = false;
+            record.size = record.item = Containers::Dimensions();
+            bool more;
+            if (!take(Serialization::BEGIN_MARK)) {
+                return false;
+            }
+            do {
+                Field field;
+                if (!takeName(field)) {
+                    return false;
+                }
+                bool read;
+                if (field == Field::IS_OPEN) {
+                    read = takeBool(record.isOpen);
+                } else if (field == Field::SIZE) {
+                    read = takeDimensions(record.size);
+                } else if (field == Field::ITEM) {
+                    read = takeDimensions(record.item);
+                    record.hasItem = true;
+                } else if (field == Field::ID) {
+                    read = takeNumber(record.id, -9223372036854775807LL - 1, 9223372036854775807LL);
+                } else {
+                    return false;
+                }
+                if (!read || !takeSeparator(more)) {
+                    return false;
+                }
+            } while (more);
+            return Serialization::buildBox(record, out) == BoxStatus::OK;
+        }
+
+        /** Moves past a box parsed by other means, keeping the index in step with it */
+        void skipTo(const char *position) {
+            consumed = position;
+            while (structural != structuralEnd && text + *structural < position) {
+                ++structural;
+            }
+        }
+    };
+
+    ParseResult parseStructured(const char *begin, const char *end, const std::vector<std::uint32_t> &index, std::vector<BoxValue> &out) {
+        IndexedParser parser(begin, end, index);
+        ParseResult result;
+        result.error = ParseError::NONE;
+        result.status = BoxStatus::OK;
+        BoxValue value;
+        for (;;) {
+            const char *start = parser.consumed;
+            const std::uint32_t *first = parser.structural;
+            if (parser.structural == parser.structuralEnd && IndexedParser::isBlank(start, end)) {
+                result.position = end - begin;
+                return result;
+            }
+            if (parser.takeBox(value)) {
+                out.push_back(value);
+                continue;
+            }
+            result = parseBox(start, end, value);
+            result.position += start - begin;
+            if (!result.ok()) {
+                return result;
+            }
+            out.push_back(value);
+            parser.structural = first;
+            parser.skipTo(begin + result.position);
+        }
+    }
+
+    ParseResult parseBoxes(const char *begin, const char *end, std::vector<BoxValue> &out) {
+        /* Offsets past the first 4 GiB do not fit the index, so the boxes there are left to the Cursor */
+        const char *indexedEnd = (std::uint64_t)(end - begin) > MAX_INDEXED ? begin + MAX_INDEXED : end;
+        std::vector<std::uint32_t> index;
+        scanStructure(begin, indexedEnd, index);
+        return parseStructured(begin, end, index, out);
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef SCANNER_H
+#define SCANNER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "box_value.h"
+#include "parser.h"
+
+namespace Containers {
+
+    /** Instruction sets the structural scanner can use */
+    enum class ScanLevel : unsigned char { SCALAR, SSE2, AVX2 };
+
+    /** Returns the best scan level supported by the running CPU */
+    ScanLevel detectScanLevel();
+
+    /** Stage one: appends the offsets of every BEGIN_MARK, END_MARK, VALUE_MARK and VALUE_SEPARATOR of the text
+     * to index. A level the CPU does not support is lowered to one it does.
+     * Throws std::invalid_argument if the text is 4 GiB or longer, the offsets would not fit. */
+    void scanStructure(const char *begin, const char *end, std::vector<std::uint32_t> &index, ScanLevel level = detectScanLevel());
+
+    /** Stage two: parses every box of the text using its structural index, appending them to out.
+     * It accepts exactly what parseBox accepts. On failure the result describes the first invalid box,
+     * with the position counted from begin, and out holds the boxes before it. The index may cover only
+     * the start of the text, the boxes past it are parsed by parseBox. */
+    ParseResult parseStructured(const char *begin, const char *end, const std::vector<std::uint32_t> &index, std::vector<BoxValue> &out);
+
+    /** Runs both stages over the text, indexing only its first 4 GiB */
+    ParseResult parseBoxes(const char *begin, const char *end, std::vector<BoxValue> &out);
+
+}
+
+#endif /* SCANNER_H */
@@ -0,0 +1,191 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "box.h"
+
+namespace Containers {
+
+    /** Fixed size block allocator dedicated to objects of type T.
+     * Memory is carved out of large slabs which are never returned to the system. Every thread keeps its own
+     * free list and exchanges blocks with the shared pool only in batches of BATCH_SIZE, so the common
+     * allocate/deallocate path takes no locks.
+     */
+    template <class T>
+    class SlabAllocator {
+       private:
+        static const std::size_t ALIGNMENT = alignof(std::max_align_t);
+        static const std::size_t BLOCK_SIZE = (sizeof(T) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        static const std::size_t BLOCKS_PER_SLAB = 4096;
+        static const std::size_t BATCH_SIZE = 256;
+
+        struct FreeBlock {
+            FreeBlock *next;
+        };
+
+        /** Plain data so it stays usable after the thread's destructors ran */
+        struct ThreadCache {
+            FreeBlock *head;
+            std::size_t count;
+            long long allocations, deallocations;
+            bool registered, retired;
+        };
+
+        struct Pool {
+            std::mutex lock;
+            FreeBlock *head = NULL;
+            std::vector<char *> slabs;
+            std::atomic<long long> allocations{0}, deallocations{0}, refills{0};
+        };
+
+        /** Returns the thread's cached blocks to the pool when the thread exits */
+        struct CacheGuard {
+            ~CacheGuard() {
+                ThreadCache &c = cache;
+                release(c, c.count);
+                flushCounters(c);
+                c.retired = true;
+            }
+        };
+
+        static thread_local ThreadCache cache;
+
+        /** The pool is intentionally leaked, boxes with static storage may outlive any destructor */
+        static Pool &pool() {
+            static Pool *p = new Pool();
+            return *p;
+        }
+
+        static void flushCounters(ThreadCache &c) {
+            pool().allocations += c.allocations;
+            pool().deallocations += c.deallocations;
+            c.allocations = c.deallocations = 0;
+        }
+
+        /** Moves up to BATCH_SIZE blocks from the pool into the cache, creating a new slab if needed */
+        static void refill(ThreadCache &c) {
+            Pool &p = pool();
+            std::lock_guard<std::mutex> guard(p.lock);
+            if (p.head == NULL) {
+                char *slab = static_cast<char *>(::operator new(BLOCK_SIZE * BLOCKS_PER_SLAB));
+                p.slabs.push_back(slab);
+                for (std::size_t i = BLOCKS_PER_SLAB; i-- > 0;) {
+                    FreeBlock *block = reinterpret_cast<FreeBlock *>(slab + i * BLOCK_SIZE);
+                    block->next = p.head;
+                    p.head = block;
+                }
+            }
+            for (std::size_t i = 0; i < BATCH_SIZE && p.head != NULL; ++i) {
+                FreeBlock *block = p.head;
+                p.head = block->next;
+                block->next = c.head;
+                c.head = block;
+                ++c.count;
+            }
+            ++p.refills;
+            flushCounters(c);
+        }
+
+        /** Moves count blocks from the cache back into the pool */
+        static void release(ThreadCache &c, std::size_t count) {
+            if (count == 0) {
+                return;
+            }
+            FreeBlock *first = c.head, *last = c.head;
+            for (std::size_t i = 1; i < count; ++i) {
+                last = last->next;
+            }
+            c.head = last->next;
+            c.count -= count;
+            Pool &p = pool();
+            std::lock_guard<std::mutex> guard(p.lock);
+            last->next = p.head;
+            p.head = first;
+            flushCounters(c);
+        }
+
+        static void registerThread(ThreadCache &c) {
+            static thread_local CacheGuard guard;
+            (void)guard;
+            c.registered = true;
+        }
+
+       public:
+        static void *allocate() {
+            ThreadCache &c = cache;
+            if (c.retired) {
+                Pool &p = pool();
+                std::lock_guard<std::mutex> guard(p.lock);
+                ++p.allocations;
+                if (p.head != NULL) {
+                    FreeBlock *block = p.head;
+                    p.head = block->next;
+                    return block;
+                }
+                return ::operator new(BLOCK_SIZE);
+            }
+            if (!c.registered) {
+                registerThread(c);
+            }
+            if (c.head == NULL) {
+                refill(c);
+            }
+            FreeBlock *block = c.head;
+            c.head = block->next;
+            --c.count;
+            ++c.allocations;
+            return block;
+        }
+
+        static void deallocate(void *ptr) {
+            if (ptr == NULL) {
+                return;
+            }
+            FreeBlock *block = static_cast<FreeBlock *>(ptr);
+            ThreadCache &c = cache;
+            if (c.retired) {
+                Pool &p = pool();
+                std::lock_guard<std::mutex> guard(p.lock);
+                ++p.deallocations;
+                block->next = p.head;
+                p.head = block;
+                return;
+            }
+            block->next = c.head;
+            c.head = block;
+            ++c.count;
+            ++c.deallocations;
+            if (c.count > 2 * BATCH_SIZE) {
+                release(c, BATCH_SIZE);
+            }
+        }
+
+        /** Counters of other threads are folded in on every batch transfer, so they may lag behind a little */
+        static AllocationStats getStats() {
+            Pool &p = pool();
+            ThreadCache &c = cache;
+            AllocationStats stats;
+            stats.allocations = p.allocations + c.allocations;
+            stats.deallocations = p.deallocations + c.deallocations;
+            stats.refills = p.refills;
+            {
+                std::lock_guard<std::mutex> guard(p.lock);
+                stats.slabs = p.slabs.size();
+            }
+            stats.blockSize = BLOCK_SIZE;
+            stats.reservedBytes = stats.slabs * BLOCK_SIZE * BLOCKS_PER_SLAB;
+            return stats;
+        }
+    };
+
+    template <class T>
+    thread_local typename SlabAllocator<T>::ThreadCache SlabAllocator<T>::cache = {NULL, 0, 0, 0, false, false};
+
+}
+
+#endif /* SLAB_H */
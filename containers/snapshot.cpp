@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "internal.h"
+#include "snapshot.h"
+
+namespace Containers {
+
+    /** Index entries are the ID followed by the record position, both 64 bits wide */
+    static const std::size_t INDEX_ENTRY_SIZE = 16;
+
+    BoxView::BoxView() : record(NULL) {
+    }
+
+    BoxView::BoxView(const unsigned char *record) : record(record) {
+    }
+
+    long long BoxView::getId() const {
+        return Binary::get(record, 8);
+    }
+
+    bool BoxView::isFull() const {
+        return record[8] & Binary::FULL;
+    }
+
+    bool BoxView::isClosed() const {
+        return !(record[8] & Binary::OPEN);
+    }
+
+    Dimensions BoxView::getSize() const {
+        return Dimensions((int)Binary::get(record + 12, 4), (int)Binary::get(record + 16, 4), (int)Binary::get(record + 20, 4));
+    }
+
+    Dimensions BoxView::getItem() const {
+        return Dimensions((int)Binary::get(record + 24, 4), (int)Binary::get(record + 28, 4), (int)Binary::get(record + 32, 4));
+    }
+
+    BoxValue BoxView::toValue() const {
+        Serialization::BoxRecord r;
+        BoxValue b;
+        Binary::decodeRecord(record, r);
+        Rules::raise(Serialization::buildBox(r, b));
+        return b;
+    }
+
+    Box BoxView::toBox() const {
+        return toValue().toBox();
+    }
+
+    BoxSnapshot::BoxSnapshot(const std::string &path) : file(new MappedFile(path)), count(0), records(NULL), index(NULL) {
+        const unsigned char *data = reinterpret_cast<const unsigned char *>(file->begin());
+        Binary::Header header;
+        const string *error = NULL;
+        if (file->size() < Binary::HEADER_SIZE) {
+            error = &Errors::Binary::TRUNCATED;
+        } else if (!Binary::decodeHeader(data, header)) {
+            error = &Errors::Binary::INVALID_HEADER;
+        } else if (header.version != Binary::VERSION) {
+            error = &Errors::Binary::UNSUPPORTED_VERSION;
+        } else if (!(header.flags & Binary::INDEXED)) {
+            error = &Errors::Snapshot::NOT_INDEXED;
+        } else if ((file->size() - Binary::HEADER_SIZE) / (Binary::RECORD_SIZE + INDEX_ENTRY_SIZE) < header.count) {
+            error = &Errors::Binary::TRUNCATED;
+        }
+        if (error != NULL) {
+            delete file;
+            throw std::logic_error(*error);
+        }
+        count = header.count;
+        records = data + Binary::HEADER_SIZE;
+        index = records + count * Binary::RECORD_SIZE;
+    }
+
+    BoxSnapshot::~BoxSnapshot() {
+        delete file;
+    }
+
+    std::size_t BoxSnapshot::size() const {
+        return count;
+    }
+
+    BoxView BoxSnapshot::at(std::size_t position) const {
+        if (position >= count) {
+            throw std::out_of_range(Errors::Snapshot::INVALID_POSITION);
+        }
+        return BoxView(records + position * Binary::RECORD_SIZE);
+    }
+
+    bool BoxSnapshot::find(long long id, BoxView &out) const {
+        std::size_t low = 0, high = count;
+        while (low < high) {
+            std::size_t middle = low + (high - low) / 2;
+            if ((long long)Binary::get(index + middle * INDEX_ENTRY_SIZE, 8) < id) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        if (low == count || (long long)Binary::get(index + low * INDEX_ENTRY_SIZE, 8) != id) {
+            return false;
+        }
+        std::size_t position = Binary::get(index + low * INDEX_ENTRY_SIZE + 8, 8);
+        if (position >= count) {
+            return false;
+        }
+        out = BoxView(records + position * Binary::RECORD_SIZE);
+        return true;
+    }
+
+    template <class T>
+    static void writeSnapshot(const std::string &path, const T *boxes, std::size_t count) {
+        std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error(Errors::Snapshot::CANNOT_OPEN + " (" + path + ")");
+        }
+        unsigned char buffer[Binary::RECORD_SIZE];
+        Binary::Header header = {Binary::VERSION, Binary::INDEXED, count};
+        Binary::encodeHeader(buffer, header);
+        file.write(reinterpret_cast<char *>(buffer), Binary::HEADER_SIZE);
+
+        std::vector<std::pair<long long, std::size_t> > ids;
+        ids.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            BoxValue b(boxes[i]);
+            Binary::encodeRecord(buffer, b);
+            file.write(reinterpret_cast<char *>(buffer), Binary::RECORD_SIZE);
+            ids.push_back(std::make_pair(b.getId(), i));
+        }
+        std::sort(ids.begin(), ids.end());
+        for (std::size_t i = 0; i < count; ++i) {
+            Binary::put(buffer, ids[i].first, 8);
+            Binary::put(buffer + 8, ids[i].second, 8);
+            file.write(reinterpret_cast<char *>(buffer), INDEX_ENTRY_SIZE);
+        }
+        if (!file.flush()) {
+            throw std::runtime_error(Errors::Snapshot::CANNOT_WRITE + " (" + path + ")");
+        }
+    }
+
+    void BoxSnapshot::write(const std::string &path, const Box *boxes, std::size_t count) {
+        writeSnapshot(path, boxes, count);
+    }
+
+    void BoxSnapshot::write(const std::string &path, const BoxValue *boxes, std::size_t count) {
+        writeSnapshot(path, boxes, count);
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <string>
+
+#include "box.h"
+#include "box_value.h"
+#include "dimensions.h"
+
+namespace Containers {
+
+    class MappedFile;
+
+    /** Read-only view of one box stored in a BoxSnapshot, decoded straight from the mapped bytes.
+     * The view is only valid while its snapshot exists. */
+    class BoxView {
+       private:
+        const unsigned char *record;
+
+       public:
+        BoxView();
+        explicit BoxView(const unsigned char *record);
+
+        long long getId() const;
+        bool isFull() const;
+        bool isClosed() const;
+        Dimensions getSize() const;
+
+        /** Returns the item inside, only meaningful when isFull() */
+        Dimensions getItem() const;
+
+        /* Materialize the box, checking it with the same rules as operator>> */
+        BoxValue toValue() const;
+        Box toBox() const;
+    };
+
+    /** BoxSnapshot maps a snapshot file into memory, so boxes can be queried without reading the file first.
+     * The file uses the binary format of writeBinary() followed by an index of the records sorted by ID.
+     * Records are accessed by position in constant time and by ID with a binary search over the index.
+     */
+    class BoxSnapshot {
+       private:
+        MappedFile *file;
+        std::size_t count;
+        const unsigned char *records, *index;
+
+       public:
+        /** Maps the snapshot at path, throwing if it cannot be opened or is not a valid snapshot */
+        explicit BoxSnapshot(const std::string &path);
+        BoxSnapshot(const BoxSnapshot &s) = delete;
+        BoxSnapshot &operator=(const BoxSnapshot &s) = delete;
+        ~BoxSnapshot();
+
+        std::size_t size() const;
+        BoxView at(std::size_t position) const;
+
+        /** Looks a box up by ID
+         * @return false if the snapshot contains no such box
+         */
+        bool find(long long id, BoxView &out) const;
+
+        /* Write a snapshot file readable by BoxSnapshot and readBinary() */
+        static void write(const std::string &path, const Box *boxes, std::size_t count);
+        static void write(const std::string &path, const BoxValue *boxes, std::size_t count);
+    };
+
+}
+
+#endif /* SNAPSHOT_H */
@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <functional>
+#include <iterator>
+
+#include "volume_index.h"
+
+namespace Containers {
+
+    /** Smallest write buffer size, so small runs are not merged after every change */
+    static const std::size_t MIN_BUFFER = 64;
+
+    /** Walks sorted and added in the order given by less, skipping the keys of sorted that are also in removed.
+     * Stops early once f returns false. */
+    template <class It, class Less, class F>
+    static void walk(It s, It sEnd, It a, It aEnd, It r, It rEnd, Less less, F f) {
+        while (s != sEnd || a != aEnd) {
+            if (a == aEnd || (s != sEnd && less(*s, *a))) {
+                while (r != rEnd && less(*r, *s)) {
+                    ++r;
+                }
+                if (r != rEnd && !less(*s, *r)) {
+                    ++r;
+                } else if (!f(*s)) {
+                    return;
+                }
+                ++s;
+            } else {
+                if (!f(*a)) {
+                    return;
+                }
+                ++a;
+            }
+        }
+    }
+
+    template <class T>
+    static bool eraseSorted(std::vector<T> &v, const T &value) {
+        typename std::vector<T>::iterator it = std::lower_bound(v.begin(), v.end(), value);
+        if (it == v.end() || value < *it) {
+            return false;
+        }
+        v.erase(it);
+        return true;
+    }
+
+    template <class T>
+    static void insertSorted(std::vector<T> &v, const T &value) {
+        v.insert(std::upper_bound(v.begin(), v.end(), value), value);
+    }
+
+    void VolumeIndex::Run::merge() {
+        std::vector<Key> merged;
+        merged.reserve(size());
+        walk(sorted.begin(), sorted.end(), added.begin(), added.end(), removed.begin(), removed.end(), std::less<Key>(), [&merged](const Key &k) {
+            merged.push_back(k);
+            return true;
+        });
+        sorted.swap(merged);
+        added.clear();
+        removed.clear();
+    }
+
+    void VolumeIndex::Run::insert(const Key &k) {
+        /* A key removed from sorted is still stored there, it only has to be revived */
+        if (!eraseSorted(removed, k)) {
+            insertSorted(added, k);
+        }
+        if (added.size() + removed.size() > std::max(MIN_BUFFER, (std::size_t)std::sqrt((double)sorted.size()))) {
+            merge();
+        }
+    }
+
+    void VolumeIndex::Run::erase(const Key &k) {
+        if (!eraseSorted(added, k)) {
+            insertSorted(removed, k);
+        }
+        if (added.size() + removed.size() > std::max(MIN_BUFFER, (std::size_t)std::sqrt((double)sorted.size()))) {
+            merge();
+        }
+    }
+
+    void VolumeIndex::Run::clear() {
+        sorted.clear();
+        added.clear();
+        removed.clear();
+    }
+
+    std::size_t VolumeIndex::Run::size() const {
+        return sorted.size() + added.size() - removed.size();
+    }
+
+    std::size_t VolumeIndex::Run::countBelow(const Key &k) const {
+        return (std::lower_bound(sorted.begin(), sorted.end(), k) - sorted.begin()) + (std::lower_bound(added.begin(), added.end(), k) - added.begin()) -
+               (std::lower_bound(removed.begin(), removed.end(), k) - removed.begin());
+    }
+
+    void VolumeIndex::Run::collect(const Key &from, const Key &to, std::vector<long long> &ids) const {
+        walk(std::lower_bound(sorted.begin(), sorted.end(), from), std::lower_bound(sorted.begin(), sorted.end(), to),
+             std::lower_bound(added.begin(), added.end(), from), std::lower_bound(added.begin(), added.end(), to),
+             std::lower_bound(removed.begin(), removed.end(), from), std::lower_bound(removed.begin(), removed.end(), to), std::less<Key>(),
+             [&ids](const Key &k) {
+                 ids.push_back(k.id);
+                 return true;
+             });
+    }
+
+    void VolumeIndex::Run::collectLargest(std::size_t count, std::vector<long long> &ids) const {
+        if (count == 0) {
+            return;
+        }
+        walk(sorted.rbegin(), sorted.rend(), added.rbegin(), added.rend(), removed.rbegin(), removed.rend(),
+             [](const Key &a, const Key &b) { return b < a; },
+             [&ids, &count](const Key &k) {
+                 ids.push_back(k.id);
+                 return --count > 0;
+             });
+    }
+
+    VolumeIndex::VolumeIndex() {
+    }
+
+    const VolumeIndex::Run &VolumeIndex::runOf(bool emptyOnly) const {
+        return emptyOnly ? empty : all;
+    }
+
+    void VolumeIndex::add(long long id, const Entry &e) {
+        Key k = {e.volume, id};
+        all.insert(k);
+        if (e.empty) {
+            empty.insert(k);
+        }
+    }
+
+    void VolumeIndex::remove(long long id, const Entry &e) {
+        Key k = {e.volume, id};
+        all.erase(k);
+        if (e.empty) {
+            empty.erase(k);
+        }
+    }
+
+    static long long volumeOf(const Dimensions &size) {
+        return (long long)size.getLength() * size.getWidth() * size.getHeight();
+    }
+
+    bool VolumeIndex::insert(long long id, const Dimensions &size, bool isEmpty) {
+        Entry e = {volumeOf(size), isEmpty};
+        if (!entries.insert(std::make_pair(id, e)).second) {
+            return false;
+        }
+        add(id, e);
+        return true;
+    }
+
+    bool VolumeIndex::insert(const Box &b) {
+        return insert(BoxValue(b));
+    }
+
+    bool VolumeIndex::insert(const BoxValue &b) {
+        return insert(b.getId(), b.getSize(), !b.isFull());
+    }
+
+    bool VolumeIndex::update(long long id, const Dimensions &size, bool isEmpty) {
+        std::unordered_map<long long, Entry>::iterator it = entries.find(id);
+        if (it == entries.end()) {
+            return false;
+        }
+        Entry e = {volumeOf(size), isEmpty};
+        if (it->second.volume != e.volume || it->second.empty != e.empty) {
+            remove(id, it->second);
+            it->second = e;
+            add(id, e);
+        }
+        return true;
+    }
+
+    bool VolumeIndex::update(const Box &b) {
+        return update(BoxValue(b));
+    }
+
+    bool VolumeIndex::update(const BoxValue &b) {
+        return update(b.getId(), b.getSize(), !b.isFull());
+    }
+
+    bool VolumeIndex::erase(long long id) {
+        std::unordered_map<long long, Entry>::iterator it = entries.find(id);
+        if (it == entries.end()) {
+            return false;
+        }
+        remove(id, it->second);
+        entries.erase(it);
+        return true;
+    }
+
+    bool VolumeIndex::contains(long long id) const {
+        return entries.count(id) != 0;
+    }
+
+    std::size_t VolumeIndex::size() const {
+        return entries.size();
+    }
+
+    void VolumeIndex::clear() {
+        entries.clear();
+        all.clear();
+        empty.clear();
+    }
+
+    std::size_t VolumeIndex::countInRange(long long minVolume, long long maxVolume, bool emptyOnly) const {
+        if (minVolume > maxVolume) {
+            return 0;
+        }
+        const Run &run = runOf(emptyOnly);
+        Key from = {minVolume, LLONG_MIN}, to = {maxVolume, LLONG_MAX};
+        return run.countBelow(to) - run.countBelow(from);
+    }
+
+    void VolumeIndex::findInRange(long long minVolume, long long maxVolume, std::vector<long long> &ids, bool emptyOnly) const {
+        if (minVolume > maxVolume) {
+            return;
+        }
+        Key from = {minVolume, LLONG_MIN}, to = {maxVolume, LLONG_MAX};
+        runOf(emptyOnly).collect(from, to, ids);
+    }
+
+    std::size_t VolumeIndex::rank(long long volume, bool emptyOnly) const {
+        Key k = {volume, LLONG_MIN};
+        return runOf(emptyOnly).countBelow(k);
+    }
+
+    void VolumeIndex::topK(std::size_t k, std::vector<long long> &ids, bool emptyOnly) const {
+        runOf(emptyOnly).collectLargest(k, ids);
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef VOLUME_INDEX_H
+#define VOLUME_INDEX_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "box.h"
+#include "box_value.h"
+#include "dimensions.h"
+
+namespace Containers {
+
+    /** VolumeIndex orders a collection of boxes by volume, the same order the Box comparison operators use,
+     * and answers range, rank and top-k queries in logarithmic time instead of scanning every box.
+     * Boxes are keyed by ID: after a box changes its size or item it is updated under the same ID, after its
+     * ID changes it is erased under the old one and inserted again. Boxes of equal volume are ordered by ID.
+     * Queries with emptyOnly consider only the boxes without an item. The index is not thread-safe.
+     */
+    class VolumeIndex {
+       private:
+        struct Key {
+            long long volume, id;
+
+            bool operator<(const Key &k) const {
+                return volume < k.volume || (volume == k.volume && id < k.id);
+            }
+        };
+
+        /** A sorted flat array of keys with a small sorted write buffer of added and removed keys,
+         * merged into the array once the buffer grows past the square root of its size */
+        class Run {
+           private:
+            std::vector<Key> sorted, added, removed;
+
+            void merge();
+
+           public:
+            void insert(const Key &k);
+            void erase(const Key &k);
+            void clear();
+            std::size_t size() const;
+
+            /** Counts the keys less than k */
+            std::size_t countBelow(const Key &k) const;
+
+            /** Appends the IDs of keys in [from, to) in ascending order */
+            void collect(const Key &from, const Key &to, std::vector<long long> &ids) const;
+
+            /** Appends the IDs of the count greatest keys in descending order */
+            void collectLargest(std::size_t count, std::vector<long long> &ids) const;
+        };
+
+        struct Entry {
+            long long volume;
+            bool empty;
+        };
+
+        std::unordered_map<long long, Entry> entries;
+        Run all, empty;
+
+        const Run &runOf(bool emptyOnly) const;
+        void add(long long id, const Entry &e);
+        void remove(long long id, const Entry &e);
+
+       public:
+        VolumeIndex();
+
+        /** Indexes a box under its ID
+         * @param isEmpty whether the box holds no item
+         * @return false if a box with the same ID is already indexed
+         */
+        bool insert(long long id, const Dimensions &size, bool isEmpty);
+        bool insert(const Box &b);
+        bool insert(const BoxValue &b);
+
+        /** Reindexes a box whose size or item changed
+         * @return false if no box has that ID
+         */
+        bool update(long long id, const Dimensions &size, bool isEmpty);
+        bool update(const Box &b);
+        bool update(const BoxValue &b);
+
+        bool erase(long long id);
+        bool contains(long long id) const;
+        std::size_t size() const;
+        void clear();
+
+        /** Counts the boxes with minVolume <= volume <= maxVolume */
+        std::size_t countInRange(long long minVolume, long long maxVolume, bool emptyOnly = false) const;
+
+        /** Appends the IDs of the boxes with minVolume <= volume <= maxVolume to ids, smallest first */
+        void findInRange(long long minVolume, long long maxVolume, std::vector<long long> &ids, bool emptyOnly = false) const;
+
+        /** Counts the boxes with a volume smaller than the given one */
+        std::size_t rank(long long volume, bool emptyOnly = false) const;
+
+        /** Appends the IDs of the k largest boxes to ids, largest first */
+        void topK(std::size_t k, std::vector<long long> &ids, bool emptyOnly = false) const;
+    };
+
+}
+
+#endif /* VOLUME_INDEX_H */
@@ -0,0 +1,94 @@
+#include <cstring>
+
+#include "internal.h"
+#include "writer.h"
+
+namespace Containers {
+
+    namespace Serialization {
+
+        static char *append(char *out, const string &text) {
+            std::memcpy(out, text.data(), text.size());
+            return out + text.size();
+        }
+
+        static char *appendField(char *out, const string &name) {
+            out = append(out, name);
+            *out++ = VALUE_MARK;
+            *out++ = ' ';
+            return out;
+        }
+
+        static char *appendSeparator(char *out) {
+            *out++ = VALUE_SEPARATOR;
+            *out++ = ' ';
+            return out;
+        }
+
+        static char *appendNumber(char *out, long long value) {
+            char digits[20];
+            int count = 0;
+            unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : value;
+            do {
+                digits[count++] = '0' + magnitude % 10;
+                magnitude /= 10;
+            } while (magnitude != 0);
+            if (value < 0) {
+                *out++ = '-';
+            }
+            while (count > 0) {
+                *out++ = digits[--count];
+            }
+            return out;
+        }
+
+        char *formatDimensions(char *out, const Containers::Dimensions &d) {
+            *out++ = BEGIN_MARK;
+            out = appendField(out, Dimensions::FIELD_LENGTH);
+            out = appendSeparator(appendNumber(out, d.getLength()));
+            out = appendField(out, Dimensions::FIELD_WIDTH);
+            out = appendSeparator(appendNumber(out, d.getWidth()));
+            out = appendField(out, Dimensions::FIELD_HEIGHT);
+            out = appendNumber(out, d.getHeight());
+            *out++ = END_MARK;
+            return out;
+        }
+
+        char *formatBox(char *out, long long id, bool isOpen, const Containers::Dimensions *item, const Containers::Dimensions &size) {
+            *out++ = BEGIN_MARK;
+            out = appendField(out, Box::FIELD_ID);
+            out = appendSeparator(appendNumber(out, id));
+            out = appendField(out, Box::FIELD_IS_OPEN);
+            out = appendSeparator(append(out, isOpen ? TRUE : FALSE));
+            if (item != NULL) {
+                out = appendField(out, Box::FIELD_ITEM);
+                out = appendSeparator(formatDimensions(out, *item));
+            }
+            out = appendField(out, Box::FIELD_SIZE);
+            out = formatDimensions(out, size);
+            *out++ = END_MARK;
+            return out;
+        }
+
+        std::ostream &writeText(std::ostream &o, const char *text, std::size_t length) {
+            if (o.width() != 0) {
+                return o << string(text, length);
+            }
+            return o.write(text, length);
+        }
+    }
+
+    void appendText(std::string &buffer, const Dimensions &d) {
+        char text[Serialization::MAX_BOX_TEXT];
+        buffer.append(text, Serialization::formatDimensions(text, d));
+    }
+
+    void appendText(std::string &buffer, const Box &b) {
+        appendText(buffer, BoxValue(b));
+    }
+
+    void appendText(std::string &buffer, const BoxValue &b) {
+        char text[Serialization::MAX_BOX_TEXT];
+        buffer.append(text, b.format(text));
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <string>
+
+#include "box.h"
+#include "box_value.h"
+#include "dimensions.h"
+
+namespace Containers {
+
+    /* Serializers appending the toString() format to a caller owned buffer, byte for byte identical to it.
+     * Reusing one buffer for many boxes stops allocating once its capacity suffices. Numbers are formatted
+     * without consulting any locale. */
+    void appendText(std::string &buffer, const Dimensions &d);
+    void appendText(std::string &buffer, const Box &b);
+    void appendText(std::string &buffer, const BoxValue &b);
+
+}
+
+#endif /* WRITER_H */
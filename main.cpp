@@ -62,13 +62,15 @@ int main() {
         Containers::Dimensions bigItem = {23, 34, 25};
 
         for (int i = 0; i < length; ++i) {
-            try {
-                boxes[i].putItem(bigItem);
+            Containers::BoxStatus status = boxes[i].tryPutItem(bigItem);
+            if (status == Containers::BoxStatus::OK) {
                 cout << "Successfully put item into the box i = " << i << '\n';
-                boxes[i].close();
+                status = boxes[i].tryClose();
+            }
+            if (status == Containers::BoxStatus::OK) {
                 cout << boxes[i] << '\n';
-            } catch (std::exception &e) {
-                cout << "Failed to put item into the box i = " << i << ": " << e.what() << '\n';
+            } else {
+                cout << "Failed to put item into the box i = " << i << ": " << Containers::describe(status) << '\n';
             }
         }
 
@@ -1,9 +1,38 @@
 #define DOCTEST_CONFIG_IMPLEMENT
 #include "doctest.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <iomanip>
+#include <limits>
+#include <thread>
+#include <vector>
 
+#include <sys/resource.h>
+
+#include "containers/assignment.h"
+#include "containers/batch_fit.h"
+#include "containers/binary.h"
 #include "containers/box.h"
+#include "containers/box_store.h"
+#include "containers/box_registry.h"
+#include "containers/box_value.h"
+#include "containers/concurrent_box.h"
+#include "containers/container.h"
+#include "containers/fit_index.h"
+#include "containers/journal.h"
+#include "containers/loader.h"
+#include "containers/parser.h"
+#include "containers/reader.h"
+#include "containers/scanner.h"
+#include "containers/snapshot.h"
+#include "containers/volume_index.h"
+#include "containers/writer.h"
 #include "containers/dimensions.h"
 
 TEST_CASE("#SET: box object numbering") {
@@ -103,6 +132,1398 @@ TEST_CASE("#LEAK: check for memory leaks") {
     REQUIRE(Containers::Box::getCurrentInstances() == 0);
 }
 
+TEST_CASE("#SLAB: boxes are served by the slab allocator") {
+    Containers::AllocationStats before = Containers::Box::getAllocationStats();
+    {
+        std::vector<Containers::Box> boxes;
+        boxes.reserve(1000);
+        for (int i = 0; i < 1000; ++i) {
+            boxes.push_back(Containers::Box({1, 2, 3}));
+        }
+        std::thread worker([] {
+            for (int i = 0; i < 1000; ++i) {
+                Containers::Box b({4, 5, 6});
+            }
+        });
+        worker.join();
+    }
+    Containers::AllocationStats after = Containers::Box::getAllocationStats();
+    REQUIRE(after.allocations - before.allocations >= 2000);
+    REQUIRE(after.allocations - after.deallocations == before.allocations - before.deallocations);
+    REQUIRE(after.slabs >= 1);
+    REQUIRE(Containers::Box::getCurrentInstances() == 0);
+}
+
+TEST_CASE("#MOVE: moving and reassigning boxes does not allocate") {
+    std::vector<Containers::Box> boxes;
+    for (int i = 0; i < 100; ++i) {
+        boxes.push_back(Containers::Box({100 - i, 2, 3}));
+    }
+    long long allocations = Containers::Box::getAllocationStats().allocations;
+    boxes.shrink_to_fit();
+    for (int i = 0; i < 1000; ++i) {
+        boxes.emplace_back(Containers::Dimensions(1, 2, 3));
+    }
+    REQUIRE(Containers::Box::getAllocationStats().allocations - allocations == 1000);
+
+    allocations = Containers::Box::getAllocationStats().allocations;
+    std::sort(boxes.begin(), boxes.end());
+    REQUIRE(std::is_sorted(boxes.begin(), boxes.end()));
+    boxes[0] = boxes[1];
+    REQUIRE(boxes[0].equals(boxes[1]));
+    REQUIRE(Containers::Box::getAllocationStats().allocations == allocations);
+
+    Containers::Box moved(std::move(boxes[0]));
+    REQUIRE(moved.equals(boxes[1]));
+    REQUIRE_THROWS(boxes[0].getId());
+    REQUIRE_NOTHROW(boxes[0].init({1, 1, 1}));
+    long long id = boxes[0].getId();
+    swap(moved, boxes[0]);
+    REQUIRE(moved.getId() == id);
+    REQUIRE(boxes[0].equals(boxes[1]));
+}
+
+TEST_CASE("#STORE: columnar box store follows box rules") {
+    Containers::BoxStore store;
+    Containers::BoxStore::Handle h = store.add({10, 10, 10});
+    Containers::Box b({10, 10, 10});
+    REQUIRE(b.getId() == store.getId(h) + 1);
+
+    REQUIRE_THROWS(store.close(h));
+    REQUIRE_NOTHROW(store.open(h));
+    REQUIRE_THROWS(store.open(h));
+    REQUIRE_THROWS(store.putItem(h, {10, 11, 10}));
+    REQUIRE_THROWS_AS(store.putItem(h, {10, 0, 10}), std::invalid_argument);
+    REQUIRE_NOTHROW(store.putItem(h, {10, 10, 12}));
+    REQUIRE_THROWS(store.close(h));
+    REQUIRE(store.takeItem(h) == Containers::Dimensions(10, 10, 12));
+    REQUIRE_THROWS(store.takeItem(h));
+    store.putItem(h, {5, 9, 10});
+    REQUIRE_NOTHROW(store.close(h));
+    REQUIRE_THROWS_AS(store.isFull(h + 1), std::out_of_range);
+
+    b.open();
+    b.putItem({1, 2, 3});
+    Containers::BoxStore::Handle copy = store.add(b);
+    REQUIRE(store.get(copy).equals(b));
+    REQUIRE(store.get(h).toString() == "{id: " + std::to_string(store.getId(h)) +
+                                           ", is_open: false, item: {length: 5, width: 9, height: 10}, "
+                                           "size: {length: 10, width: 10, height: 10}}");
+    for (int i = 0; i < 200; ++i) {
+        store.add({1, 1, i + 1});
+    }
+    REQUIRE(store.size() == 202);
+    REQUIRE(store.countFull() == 2);
+    REQUIRE(store.countOpen() == 1);
+    REQUIRE(store.totalVolume() == 2000 + 200 * 201 / 2);
+}
+
+TEST_CASE("#VALUE: inline box values") {
+    Containers::Box box({10, 20, 30});
+    box.open();
+    box.putItem({5, 5, 40});
+
+    Containers::BoxValue values[2];
+    values[0] = Containers::BoxValue(box);
+    std::memcpy(&values[1], &values[0], sizeof(values[0]));
+    REQUIRE(values[1].toString() == box.toString());
+    REQUIRE(values[1].toBox().equals(box));
+    REQUIRE_THROWS(values[1].close());
+    REQUIRE(values[1].takeItem() == Containers::Dimensions(5, 5, 40));
+    REQUIRE_NOTHROW(values[1].close());
+    REQUIRE_FALSE(values[1].equals(values[0]));
+
+    Containers::BoxValue fresh({1, 2, 3}), fromStream;
+    std::stringstream ss;
+    ss << fresh;
+    ss >> fromStream;
+    REQUIRE(fromStream.equals(fresh));
+    REQUIRE(fresh.getId() > box.getId());
+    REQUIRE_THROWS_AS(Containers::BoxValue({1, 0, 3}), std::invalid_argument);
+
+    Containers::BoxValue unsized;
+    REQUIRE_THROWS_AS(unsized.toBox(), std::invalid_argument);
+    REQUIRE_THROWS_AS(unsized.assignTo(box), std::invalid_argument);
+    REQUIRE(box.isFull());
+}
+
+TEST_CASE("#TRY: status returning operations") {
+    using Containers::BoxStatus;
+    Containers::Box b;
+    Containers::Dimensions item;
+    REQUIRE(b.tryOpen() == BoxStatus::UNINITIALIZED);
+    b.init({10, 10, 10});
+
+    REQUIRE(b.tryClose() == BoxStatus::ALREADY_CLOSED);
+    REQUIRE(b.tryPutItem({1, 1, 1}) == BoxStatus::PUTING_TO_CLOSED);
+    REQUIRE(b.tryTakeItem(item) == BoxStatus::TAKING_FROM_CLOSED);
+    REQUIRE(b.tryOpen() == BoxStatus::OK);
+    REQUIRE(b.tryOpen() == BoxStatus::ALREADY_OPENED);
+    REQUIRE(b.tryTakeItem(item) == BoxStatus::TAKING_FROM_EMPTY);
+    REQUIRE(b.tryPutItem({0, 1, 1}) == BoxStatus::INVALID_DIMENSIONS);
+    REQUIRE(b.tryPutItem({11, 1, 1}) == BoxStatus::ITEM_DOES_NOT_FIT);
+    REQUIRE(b.tryPutItem({10, 10, 11}) == BoxStatus::OK);
+    REQUIRE(b.tryPutItem({1, 1, 1}) == BoxStatus::PUTING_TO_FULL);
+    REQUIRE(b.tryClose() == BoxStatus::ITEM_TOO_HIGH_TO_CLOSE);
+    REQUIRE_FALSE(b.isClosed());
+    REQUIRE(b.tryTakeItem(item) == BoxStatus::OK);
+    REQUIRE(item == Containers::Dimensions(10, 10, 11));
+
+    try {
+        b.takeItem();
+        FAIL("takeItem should throw");
+    } catch (std::logic_error &e) {
+        REQUIRE(Containers::describe(BoxStatus::TAKING_FROM_EMPTY) == e.what());
+    }
+    REQUIRE(Containers::describe(BoxStatus::OK).empty());
+
+    Containers::BoxStore store;
+    REQUIRE(store.tryOpen(0) == BoxStatus::UNINITIALIZED);
+    Containers::BoxValue value({1, 1, 1});
+    REQUIRE(value.tryClose() == BoxStatus::ALREADY_CLOSED);
+}
+
+/* Level 0 leaves uninitialized usage undefined, see CONTAINERS_CHECK_LEVEL in internal.h */
+#if !defined(CONTAINERS_CHECK_LEVEL) || CONTAINERS_CHECK_LEVEL > 0
+TEST_CASE("#CHECK: uninitialized usage is reported") {
+    Containers::Box b, other({1, 1, 1});
+    REQUIRE_THROWS_AS(b.getId(), std::logic_error);
+    REQUIRE_THROWS_AS(b.toString(), std::logic_error);
+    REQUIRE_THROWS_AS((void)(other < b), std::logic_error);
+    REQUIRE_THROWS_AS(other = b, std::logic_error);
+    try {
+        b.isFull();
+        FAIL("isFull() of an uninitialized box did not throw");
+    } catch (std::logic_error &e) {
+        REQUIRE(std::string(e.what()).find(Containers::describe(Containers::BoxStatus::UNINITIALIZED)) == 0);
+    }
+}
+#endif
+
+TEST_CASE("#THREADS: unique IDs and instance counting across threads") {
+    const int threads = 4, perThread = 5000;
+    std::vector<std::vector<long long> > ids(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.push_back(std::thread([&ids, t] {
+            std::vector<Containers::Box> boxes;
+            for (int i = 0; i < perThread; ++i) {
+                boxes.push_back(Containers::Box({1, 1, 1}));
+                ids[t].push_back(boxes.back().getId());
+            }
+        }));
+    }
+    for (std::size_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+    std::vector<long long> all;
+    for (int t = 0; t < threads; ++t) {
+        REQUIRE(std::is_sorted(ids[t].begin(), ids[t].end()));
+        all.insert(all.end(), ids[t].begin(), ids[t].end());
+    }
+    std::sort(all.begin(), all.end());
+    REQUIRE(std::unique(all.begin(), all.end()) == all.end());
+    REQUIRE(Containers::Box::getCurrentInstances() == 0);
+}
+
+TEST_CASE("#CONCURRENT: exactly one winner per shared box") {
+    const int threads = 4, boxCount = 256;
+    std::vector<Containers::ConcurrentBox *> boxes;
+    for (int i = 0; i < boxCount; ++i) {
+        boxes.push_back(new Containers::ConcurrentBox(Containers::Dimensions(10, 10, 10)));
+    }
+    std::vector<std::atomic<int> > opened(boxCount), put(boxCount), taken(boxCount);
+    for (int phase = 0; phase < 3; ++phase) {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.push_back(std::thread([&, t, phase] {
+                for (int round = 0; round < 20; ++round) {
+                    for (int i = 0; i < boxCount; ++i) {
+                        Containers::Dimensions item(t + 1, 1, 1);
+                        if (phase == 0 && boxes[i]->tryOpen() == Containers::BoxStatus::OK) {
+                            ++opened[i];
+                        }
+                        if (phase == 1 && boxes[i]->tryPutItem(item) == Containers::BoxStatus::OK) {
+                            ++put[i];
+                        }
+                        if (phase == 2 && boxes[i]->tryTakeItem(item) == Containers::BoxStatus::OK) {
+                            ++taken[i];
+                        }
+                        boxes[i]->load();
+                    }
+                }
+            }));
+        }
+        for (std::size_t t = 0; t < workers.size(); ++t) {
+            workers[t].join();
+        }
+    }
+    for (int i = 0; i < boxCount; ++i) {
+        REQUIRE(opened[i] == 1);
+        REQUIRE(put[i] == 1);
+        REQUIRE(taken[i] == 1);
+        REQUIRE_FALSE(boxes[i]->isFull());
+    }
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.push_back(std::thread([&, t] {
+            for (int round = 0; round < 2000; ++round) {
+                int i = (round * (t + 1)) % boxCount;
+                Containers::Dimensions item(t + 1, 1, 1);
+                if (round % 2 == 0 && boxes[i]->tryPutItem(item) == Containers::BoxStatus::OK) {
+                    ++put[i];
+                } else if (boxes[i]->tryTakeItem(item) == Containers::BoxStatus::OK) {
+                    ++taken[i];
+                }
+            }
+        }));
+    }
+    for (std::size_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+    for (int i = 0; i < boxCount; ++i) {
+        REQUIRE(put[i] - taken[i] == (boxes[i]->isFull() ? 1 : 0));
+        delete boxes[i];
+    }
+
+    Containers::Box box({5, 5, 5});
+    box.open();
+    box.putItem({5, 5, 6});
+    Containers::ConcurrentBox shared((Containers::BoxValue(box)));
+    REQUIRE(shared.toString() == box.toString());
+    REQUIRE_THROWS(shared.close());
+    REQUIRE_THROWS(shared.putItem({1, 1, 1}));
+    REQUIRE(shared.takeItem() == Containers::Dimensions(5, 5, 6));
+    REQUIRE_NOTHROW(shared.close());
+    REQUIRE(shared.isClosed());
+}
+
+TEST_CASE("#REGISTRY: concurrent lookup by ID") {
+    const int threads = 4, perThread = 1000;
+    {
+        Containers::BoxRegistry registry;
+        std::vector<std::vector<long long> > ids(threads);
+        std::vector<std::thread> workers;
+        std::atomic<int> failures(0);
+        for (int t = 0; t < threads; ++t) {
+            workers.push_back(std::thread([&registry, &ids, &failures, t] {
+                for (int i = 0; i < perThread; ++i) {
+                    Containers::Box b({t + 1, 1, 1});
+                    ids[t].push_back(b.getId());
+                    failures += !registry.insert(b);
+                }
+                Containers::Box found;
+                for (int i = 0; i < perThread; i += 2) {
+                    failures += !registry.find(ids[t][i], found) || found.getId() != ids[t][i];
+                    failures += !registry.erase(ids[t][i + 1]);
+                }
+            }));
+        }
+        for (std::size_t t = 0; t < workers.size(); ++t) {
+            workers[t].join();
+        }
+        REQUIRE(failures == 0);
+        REQUIRE(registry.size() == threads * perThread / 2);
+        REQUIRE_FALSE(registry.contains(ids[0][1]));
+        Containers::Box duplicate({1, 1, 1});
+        REQUIRE(registry.insert(duplicate));
+        REQUIRE_FALSE(registry.insert(duplicate));
+        REQUIRE(registry.erase(duplicate.getId()));
+
+        REQUIRE(registry.update(ids[1][0], [](Containers::Box &b) { b.open(); }));
+        Containers::Box found;
+        REQUIRE(registry.find(ids[1][0], found));
+        REQUIRE_FALSE(found.isClosed());
+        REQUIRE_FALSE(registry.update(-1, [](Containers::Box &b) { b.open(); }));
+
+        int opened = 0;
+        registry.forEach([&opened](const Containers::Box &b) { opened += b.isClosed() ? 0 : 1; });
+        REQUIRE(opened == 1);
+    }
+    REQUIRE(Containers::Box::getCurrentInstances() == 0);
+}
+
+TEST_CASE("#PARSER: buffer parser matches the stream operators") {
+    Containers::Box open({10, 20, 30}), full({10, 20, 30});
+    open.open();
+    full.open();
+    full.putItem({5, 20, 25});
+    full.close();
+    const std::string inputs[] = {
+        open.toString(),
+        full.toString(),
+        "{id:  7 ,\n is_open : true , size: {length: 1, width: 2, height: 3}}",
+        "\t{size: {height: 3, length: 1, width: 2}, id: -4, item: {length: 1, width: 2, height: 3}, is_open: false}",
+        "{id: 1, size: {length: 1, width: 2, height: 3}, item: {length: 1, width: 2, height: 30}, is_open: false}",
+        "{id: 1, size: {length: 1, width: 2, height: 3}, item: {length: 1, width: 3, height: 3}, is_open: true}",
+        "{id: 1, size: {length: 0, width: 2, height: 3}, is_open: true}",
+        "{id: 1, bogus: 2}",
+        "{id: 1, size: {length: 1, id: 2, height: 3}}",
+        "{id:1, is_open: true}",
+        "{id: 99999999999999999999, is_open: true}",
+        "{id: 1, is_open: maybe}",
+        "garbage",
+    };
+    for (const std::string &input : inputs) {
+        CAPTURE(input);
+        Containers::Box fromStream({1, 1, 1}), fromBuffer({1, 1, 1});
+        std::istringstream ss(input);
+        bool streamOk = true;
+        try {
+            ss >> fromStream;
+        } catch (std::exception &) {
+            streamOk = false;
+        }
+        Containers::ParseResult r = Containers::parseBox(input.data(), input.data() + input.size(), fromBuffer);
+        REQUIRE(r.ok() == streamOk);
+        if (streamOk) {
+            REQUIRE(fromBuffer.equals(fromStream));
+            REQUIRE(r.position == input.size());
+        } else {
+            REQUIRE_FALSE(Containers::describe(r).empty());
+        }
+    }
+
+    const std::string text = full.toString();
+    Containers::BoxValue value;
+    for (std::size_t length = 0; length < text.size(); ++length) {
+        REQUIRE(Containers::parseBox(text.data(), text.data() + length, value).error == Containers::ParseError::UNEXPECTED_END);
+    }
+    Containers::ParseResult r = Containers::parseBox(inputs[4].data(), inputs[4].data() + inputs[4].size(), value);
+    REQUIRE(r.error == Containers::ParseError::INVALID_BOX);
+    REQUIRE(r.status == Containers::BoxStatus::ITEM_TOO_HIGH_TO_CLOSE);
+    r = Containers::parseBox(inputs[7].data(), inputs[7].data() + inputs[7].size(), value);
+    REQUIRE(r.error == Containers::ParseError::UNKNOWN_VALUE);
+    REQUIRE(r.position == 8);
+
+    Containers::Dimensions d;
+    const char dimensions[] = "{length: 1, width: 2, height: 3} trailing";
+    r = Containers::parseDimensions(dimensions, dimensions + sizeof(dimensions) - 1, d);
+    REQUIRE(r.ok());
+    REQUIRE(d == Containers::Dimensions(1, 2, 3));
+    REQUIRE(r.position == 32);
+}
+
+TEST_CASE("#WRITER: buffer serializer matches toString") {
+    Containers::Box b({2147483647, 1, 300});
+    b.open();
+    b.putItem({1, 1, 1});
+    const std::string expected = "{id: " + std::to_string(b.getId()) +
+                                 ", is_open: true, item: {length: 1, width: 1, height: 1}, "
+                                 "size: {length: 2147483647, width: 1, height: 300}}";
+    REQUIRE(b.toString() == expected);
+
+    std::string buffer;
+    Containers::appendText(buffer, b);
+    Containers::appendText(buffer, Containers::Dimensions(-5, std::numeric_limits<int>::min(), 0));
+    REQUIRE(buffer == expected + "{length: -5, width: -2147483648, height: 0}");
+
+    const char *data = buffer.data();
+    buffer.clear();
+    Containers::appendText(buffer, Containers::BoxValue(b));
+    REQUIRE(buffer == expected);
+    REQUIRE(buffer.data() == data);
+
+    std::ostringstream os;
+    os << b << std::setw(5) << Containers::Dimensions(1, 2, 3).toString().size();
+    os << std::setw(45) << Containers::Dimensions(1, 2, 3);
+    REQUIRE(os.str() == expected + "   32" + std::string(13, ' ') + "{length: 1, width: 2, height: 3}");
+}
+
+TEST_CASE("#BINARY: binary snapshots round trip") {
+    std::vector<Containers::Box> boxes;
+    for (int i = 0; i < 3000; ++i) {
+        boxes.push_back(Containers::Box({i + 1, 20, 30}));
+        if (i % 2) {
+            boxes.back().open();
+            boxes.back().putItem({1, 20, 30 + i % 3});
+        }
+        if (i % 4 == 1 && i % 3 == 0) {
+            boxes.back().close();
+        }
+    }
+    boxes.back()++;
+
+    std::stringstream ss;
+    Containers::writeBinary(ss, boxes.data(), boxes.size());
+    const std::string snapshot = ss.str();
+    REQUIRE(snapshot.size() == 16 + 40 * boxes.size());
+    REQUIRE(snapshot.compare(0, 4, "BOXS") == 0);
+
+    std::vector<Containers::Box> restored(1, Containers::Box({1, 1, 1}));
+    Containers::readBinary(ss, restored);
+    REQUIRE(restored.size() == boxes.size() + 1);
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        REQUIRE(restored[i + 1].equals(boxes[i]));
+    }
+
+    std::vector<Containers::BoxValue> values;
+    std::istringstream truncated(snapshot.substr(0, snapshot.size() - 1));
+    REQUIRE_THROWS_AS(Containers::readBinary(truncated, values), std::logic_error);
+    std::istringstream garbage("garbage, not a snapshot");
+    REQUIRE_THROWS_AS(Containers::readBinary(garbage, values), std::logic_error);
+    std::string broken = snapshot;
+    broken[16 + 12] = 0;
+    broken[16 + 13] = 0;
+    std::istringstream invalid(broken);
+    REQUIRE_THROWS_AS(Containers::readBinary(invalid, values), std::invalid_argument);
+    REQUIRE(values.empty());
+}
+
+TEST_CASE("#SNAPSHOT: mapped snapshots give random access by ID") {
+    const std::string path = "test_snapshot.bin";
+    std::vector<Containers::BoxValue> boxes;
+    for (int i = 0; i < 1000; ++i) {
+        boxes.push_back(Containers::BoxValue((i * 7919LL) % 1000 * 3, {i % 10 + 1, 5, 5}));
+        if (i % 3 == 0) {
+            boxes.back().open();
+            boxes.back().putItem({1, 1, 1});
+        }
+    }
+    Containers::BoxSnapshot::write(path, boxes.data(), boxes.size());
+    {
+        Containers::BoxSnapshot snapshot(path);
+        REQUIRE(snapshot.size() == boxes.size());
+        REQUIRE(snapshot.at(999).getId() == boxes[999].getId());
+        REQUIRE(snapshot.at(3).isClosed() == false);
+        REQUIRE(snapshot.at(3).getItem() == Containers::Dimensions(1, 1, 1));
+        REQUIRE_THROWS_AS(snapshot.at(1000), std::out_of_range);
+        for (std::size_t i = 0; i < boxes.size(); ++i) {
+            Containers::BoxView view;
+            REQUIRE(snapshot.find(boxes[i].getId(), view));
+            REQUIRE(view.getSize() == boxes[i].getSize());
+            REQUIRE(view.toValue().equals(boxes[i]));
+        }
+        Containers::BoxView view;
+        REQUIRE_FALSE(snapshot.find(1, view));
+        REQUIRE_FALSE(snapshot.find(3000, view));
+        REQUIRE(snapshot.find(0, view));
+        REQUIRE(view.toBox().equals(boxes[0].toBox()));
+    }
+
+    std::ifstream file(path.c_str(), std::ios::binary);
+    std::vector<Containers::BoxValue> restored;
+    Containers::readBinary(file, restored);
+    REQUIRE(restored.size() == boxes.size());
+    file.close();
+
+    std::stringstream plain;
+    Containers::writeBinary(plain, boxes.data(), boxes.size());
+    std::ofstream(path.c_str(), std::ios::binary) << plain.str();
+    REQUIRE_THROWS_AS(Containers::BoxSnapshot{path}, std::logic_error);
+    std::remove(path.c_str());
+    REQUIRE_THROWS_AS(Containers::BoxSnapshot{path}, std::runtime_error);
+}
+
+TEST_CASE("#READER: streaming reader across buffer boundaries") {
+    std::vector<Containers::Box> boxes;
+    std::ostringstream os;
+    for (int i = 0; i < 500; ++i) {
+        boxes.push_back(Containers::Box({i % 7 + 1, 20, 30}));
+        if (i % 2) {
+            boxes.back().open();
+            boxes.back().putItem({1, 2, 3});
+        }
+        os << boxes.back() << (i % 3 ? "\n" : " \n\t ");
+    }
+    const std::string dump = os.str();
+
+    std::istringstream input(dump);
+    Containers::BoxReader reader(input, false, 300);
+    Containers::Box b;
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        REQUIRE(reader.next(b));
+        REQUIRE(b.equals(boxes[i]));
+    }
+    REQUIRE_FALSE(reader.next(b));
+    REQUIRE(reader.getOffset() == dump.size());
+    REQUIRE(reader.getLine() == 501);
+
+    std::string broken = dump;
+    std::size_t fourth = 0;
+    for (int i = 0; i < 3; ++i) {
+        fourth = broken.find('\n', fourth) + 1;
+    }
+    broken.replace(broken.find("size", fourth), 4, "sise");
+    broken += "{id: 1, is_open: tr";
+    std::istringstream strict(broken);
+    Containers::BoxReader failing(strict, false, 300);
+    for (int i = 0; i < 3; ++i) {
+        REQUIRE(failing.next(b));
+    }
+    try {
+        failing.next(b);
+        FAIL("invalid record was read");
+    } catch (std::logic_error &e) {
+        REQUIRE(std::string(e.what()).find("line 4,") != std::string::npos);
+    }
+
+    std::istringstream lenient(broken);
+    Containers::BoxReader skipping(lenient, true, 300);
+    std::size_t read = 0;
+    while (skipping.next(b)) {
+        ++read;
+    }
+    REQUIRE(read == boxes.size() - 1);
+    REQUIRE(b.equals(boxes.back()));
+    REQUIRE(skipping.getSkipped() == 2);
+    REQUIRE(skipping.getLastError().result.error == Containers::ParseError::UNEXPECTED_END);
+    REQUIRE(skipping.getLastError().line == 501);
+    REQUIRE(skipping.getLastError().offset == broken.size());
+
+    std::istringstream huge("{id: 1," + std::string(1000, ' ') + "isOpen: false}");
+    Containers::BoxReader small(huge, true, 300);
+    REQUIRE_THROWS_AS(small.next(b), std::logic_error);
+}
+
+TEST_CASE("#LOADER: parallel loading keeps the input order") {
+    std::vector<Containers::Box> boxes;
+    std::ostringstream os;
+    for (int i = 0; i < 20000; ++i) {
+        boxes.push_back(Containers::Box({i % 7 + 1, 20, 30}));
+        if (i % 2) {
+            boxes.back().open();
+            boxes.back().putItem({1, 2, 3});
+        }
+        os << boxes.back() << (i % 5 ? "\n" : "  ");
+    }
+    const std::string dump = os.str();
+
+    for (unsigned threads = 0; threads <= 4; ++threads) {
+        std::vector<Containers::Box> loaded(1, Containers::Box({1, 1, 1}));
+        Containers::loadBoxes(dump.data(), dump.data() + dump.size(), loaded, threads);
+        REQUIRE(loaded.size() == boxes.size() + 1);
+        for (std::size_t i = 0; i < boxes.size(); ++i) {
+            REQUIRE(loaded[i + 1].equals(boxes[i]));
+        }
+    }
+
+    const std::string path = "test_dump.txt";
+    std::ofstream(path.c_str()) << dump;
+    std::vector<Containers::BoxValue> values;
+    Containers::loadBoxes(path, values, 3);
+    REQUIRE(values.size() == boxes.size());
+    REQUIRE(values.back().equals(Containers::BoxValue(boxes.back())));
+    std::remove(path.c_str());
+
+    std::string broken = dump;
+    std::size_t late = broken.find("size", broken.size() * 3 / 4), early = broken.find("height: 30", broken.size() / 2);
+    broken.replace(late, 4, "sise");
+    broken.replace(early + 8, 2, "-1");
+    std::string line = std::to_string(1 + std::count(broken.begin(), broken.begin() + early, '\n'));
+    values.clear();
+    try {
+        Containers::loadBoxes(broken.data(), broken.data() + broken.size(), values, 4);
+        FAIL("invalid input was loaded");
+    } catch (std::invalid_argument &e) {
+        REQUIRE(std::string(e.what()).find("(line " + line + ",") != std::string::npos);
+    }
+    REQUIRE(values.empty());
+    REQUIRE_THROWS_AS(Containers::loadBoxes(path, values), std::runtime_error);
+
+    /* A record missing a colon, spread over where the first chunk ends, whose item looks like the next record */
+    std::string crossing = dump;
+    std::size_t start = crossing.rfind('{', crossing.find("{id", crossing.size() / 16 - 1000));
+    std::size_t mark = crossing.find("size: ", start);
+    crossing.replace(mark, 6, "size" + std::string(20000, ' '));
+    std::string sequential, parallel;
+    try {
+        std::istringstream input(crossing);
+        Containers::BoxReader reader(input);
+        Containers::BoxValue value;
+        while (reader.next(value)) {
+        }
+    } catch (std::logic_error &e) {
+        sequential = e.what();
+    }
+    try {
+        Containers::loadBoxes(crossing.data(), crossing.data() + crossing.size(), values, 4);
+    } catch (std::logic_error &e) {
+        parallel = e.what();
+    }
+    REQUIRE_FALSE(sequential.empty());
+    REQUIRE(parallel == sequential);
+}
+
+TEST_CASE("#SCANNER: structural index and indexed parsing") {
+    std::string text;
+    for (int i = 0; i < 1000; ++i) {
+        text += "{}:, \nab0"[(i * 7919) % 10];
+    }
+    for (std::size_t length = 0; length <= text.size(); length += 37) {
+        std::vector<std::uint32_t> scalar, sse, avx;
+        Containers::scanStructure(text.data(), text.data() + length, scalar, Containers::ScanLevel::SCALAR);
+        Containers::scanStructure(text.data(), text.data() + length, sse, Containers::ScanLevel::SSE2);
+        Containers::scanStructure(text.data(), text.data() + length, avx, Containers::ScanLevel::AVX2);
+        REQUIRE(scalar == sse);
+        REQUIRE(scalar == avx);
+        for (std::size_t i = 0; i < scalar.size(); ++i) {
+            REQUIRE(std::string("{}:,").find(text[scalar[i]]) != std::string::npos);
+        }
+    }
+
+    std::vector<Containers::Box> boxes;
+    std::ostringstream os;
+    for (int i = 0; i < 2000; ++i) {
+        boxes.push_back(Containers::Box({i % 7 + 1, 20, 30}));
+        if (i % 2) {
+            boxes.back().open();
+            boxes.back().putItem({1, 2, 3});
+        }
+        os << boxes.back() << (i % 3 ? "\n" : " \t");
+    }
+    const std::string dump = os.str();
+    std::vector<Containers::BoxValue> values;
+    REQUIRE(Containers::parseBoxes(dump.data(), dump.data() + dump.size(), values).ok());
+    REQUIRE(values.size() == boxes.size());
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        REQUIRE(values[i].toBox().equals(boxes[i]));
+    }
+    /* Past 4 GiB the index stops short of the text like this, the rest is parsed without it */
+    for (std::size_t cut = dump.size() / 2; cut < dump.size() / 2 + 100; cut += 7) {
+        std::vector<std::uint32_t> index;
+        std::vector<Containers::BoxValue> partial;
+        Containers::scanStructure(dump.data(), dump.data() + cut, index);
+        REQUIRE(Containers::parseStructured(dump.data(), dump.data() + dump.size(), index, partial).ok());
+        REQUIRE(partial.size() == boxes.size());
+        REQUIRE(partial.back().toBox().equals(boxes.back()));
+        REQUIRE(partial[boxes.size() / 2].toBox().equals(boxes[boxes.size() / 2]));
+    }
+
+    const char *inputs[] = {
+        "",
+        "  \n",
+        "{id :5, is_open:false, size: {length: 1, width: 1 , height:\t1}}",
+        "{id:5, is_open: false, size: {length: 1, width: 1, height: 1}}",
+        "{id: 5, is_open: false, size:{length: 1, width: 1, height: 1}}",
+        "{id: 5, is_open: false, size: {length: 1, width: 1, height: 0}}",
+        "{id: +5, is_open: true, size: {length: 2, width: 2, height: 2}, item: {length: 1, width: 1, height: 3}}",
+        "{id: - 5, is_open: false, size: {length: 1, width: 1, height: 1}}",
+        "{id: 99999999999999999999, is_open: false, size: {length: 1, width: 1, height: 1}}",
+        "{id: 5, is_open: maybe, size: {length: 1, width: 1, height: 1}}",
+        "{id: 5, length: 1, size: {length: 1, width: 1, height: 1}}",
+        "{id: 5, is_open: false, size: {length: 1, width: 1, height: 1}} x",
+        "{id: 5, is_open: false, size: {length: 1, width: 1, height: 1}}{id: 6, is_open: false, size: {length: 1",
+        "{id: 5, is id: 6}",
+    };
+    for (const char *input : inputs) {
+        const char *end = input + std::strlen(input);
+        std::vector<Containers::BoxValue> expected, actual;
+        Containers::ParseResult r;
+        r.error = Containers::ParseError::NONE;
+        r.position = 0;
+        for (const char *p = input;;) {
+            while (p != end && std::isspace(*p)) {
+                ++p;
+            }
+            if (p == end) {
+                r.position = end - input;
+                break;
+            }
+            Containers::BoxValue b;
+            r = Containers::parseBox(p, end, b);
+            r.position += p - input;
+            if (!r.ok()) {
+                break;
+            }
+            expected.push_back(b);
+            p = input + r.position;
+        }
+        Containers::ParseResult indexed = Containers::parseBoxes(input, end, actual);
+        CAPTURE(input);
+        REQUIRE(indexed.error == r.error);
+        REQUIRE(indexed.position == r.position);
+        REQUIRE(actual.size() == expected.size());
+    }
+}
+
+TEST_CASE("#SELECT: filtered and projected loading") {
+    std::vector<Containers::Box> boxes;
+    std::ostringstream os;
+    for (int i = 0; i < 5000; ++i) {
+        boxes.push_back(Containers::Box({i % 7 + 1, 20, 30}));
+        if (i % 2) {
+            boxes.back().open();
+            boxes.back().putItem({1, 2, 3});
+        }
+        os << boxes.back() << '\n';
+    }
+    os << "{id: 1, is_open: true, size: {length: 0, width: 1, height: 1}, item: {length: 5, width: 5, height: 5}}";
+    const std::string dump = os.str();
+    const char *begin = dump.data(), *end = dump.data() + dump.size();
+
+    std::vector<Containers::BoxFields> full;
+    Containers::BoxQuery fullOnly(Containers::BoxQuery::SIZE, [](const Containers::BoxFields &b) {
+        return b.hasItem && b.size.computeVolume() >= 5 * 20 * 30;
+    });
+    Containers::selectBoxes(begin, end, fullOnly, full, 4);
+    std::size_t expected = 0;
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        if (boxes[i].isFull() && i % 7 + 1 >= 5) {
+            REQUIRE(full.at(expected).size == Containers::Dimensions(i % 7 + 1, 20, 30));
+            ++expected;
+        }
+    }
+    REQUIRE(full.size() == expected);
+    REQUIRE(full[0].id == 0);
+    REQUIRE(full[0].item == Containers::Dimensions());
+
+    std::vector<Containers::BoxFields> closed;
+    Containers::selectBoxes(begin, end, Containers::BoxQuery(Containers::BoxQuery::ID | Containers::BoxQuery::IS_OPEN,
+                                                             [](const Containers::BoxFields &b) { return !b.isOpen; }), closed);
+    REQUIRE(closed.size() == boxes.size() / 2);
+    REQUIRE(closed.back().id == boxes[boxes.size() - 2].getId());
+
+    std::vector<Containers::BoxFields> all;
+    REQUIRE_THROWS_AS(Containers::selectBoxes(begin, end, Containers::BoxQuery(), all, 2), std::invalid_argument);
+    REQUIRE(all.empty());
+    Containers::selectBoxes(begin, end, Containers::BoxQuery(Containers::BoxQuery::ITEM), all, 2);
+    REQUIRE(all.size() == boxes.size() + 1);
+    REQUIRE(all.back().item == Containers::Dimensions(5, 5, 5));
+
+    const unsigned sizeAndItem = Containers::BoxQuery::SIZE | Containers::BoxQuery::ITEM;
+    std::string tooLarge = "{id: 1, is_open: true, size: {length: 2, width: 2, height: 2}, item: {length: 5, width: 5, height: 5}}";
+    std::vector<Containers::BoxFields> partial;
+    REQUIRE_THROWS_AS(Containers::selectBoxes(tooLarge.data(), tooLarge.data() + tooLarge.size(), Containers::BoxQuery(sizeAndItem), partial),
+                      std::logic_error);
+    Containers::selectBoxes(tooLarge.data(), tooLarge.data() + tooLarge.size(), Containers::BoxQuery(Containers::BoxQuery::ITEM), partial);
+    REQUIRE(partial.size() == 1);
+    std::string flatItem = "{id: 1, is_open: true, size: {length: 2, width: 2, height: 2}, item: {length: 0, width: 1, height: 1}}";
+    REQUIRE_THROWS_AS(
+        Containers::selectBoxes(flatItem.data(), flatItem.data() + flatItem.size(), Containers::BoxQuery(Containers::BoxQuery::ITEM), partial),
+        std::logic_error);
+    Containers::selectBoxes(flatItem.data(), flatItem.data() + flatItem.size(), Containers::BoxQuery(Containers::BoxQuery::SIZE), partial);
+    REQUIRE(partial.size() == 2);
+
+    std::string broken = "{id: 1, is_open: false, size: {length: 1, width: 1, height: 1}, item: {length: 1";
+    REQUIRE_THROWS_AS(Containers::selectBoxes(broken.data(), broken.data() + broken.size(), fullOnly, all), std::logic_error);
+}
+
+TEST_CASE("#VALIDATE: validation collects every error") {
+    const char *broken[] = {
+        "{id: 1, is_open: false, size: {length: 1, width: 1, height: 0}}",
+        "{id: 2, is_open: false, size: {length: 9, width: 9, height: 1}, item: {length: 1, width: 1, height: 2}}",
+        "{id: 3, is_open: maybe, size: {length: 1, width: 1, height: 1}}",
+        "{id: 4, colour: red}",
+        "garbage",
+    };
+    std::ostringstream os;
+    std::size_t valid = 0;
+    for (int i = 0; i < 20000; ++i) {
+        if (i % 1000 == 999) {
+            os << broken[i / 1000 % 5] << '\n';
+            continue;
+        }
+        Containers::Box b({i % 7 + 1, 20, 30});
+        if (i % 2) {
+            b.open();
+            b.putItem({1, 2, 3});
+        }
+        os << b << '\n';
+        ++valid;
+    }
+    const std::string dump = os.str();
+
+    std::istringstream input(dump);
+    Containers::BoxReader reader(input, true);
+    std::vector<Containers::ReadError> expected;
+    for (Containers::BoxValue b; reader.next(b) || reader.getSkipped() != expected.size();) {
+        if (reader.getSkipped() != expected.size()) {
+            expected.push_back(reader.getLastError());
+        }
+    }
+    REQUIRE(expected.size() == 20);
+
+    for (unsigned threads = 1; threads <= 4; threads += 3) {
+        Containers::ValidationReport report = Containers::validateBoxes(dump.data(), dump.data() + dump.size(), threads);
+        REQUIRE_FALSE(report.ok());
+        REQUIRE(report.boxes == valid);
+        REQUIRE(report.errors.size() == expected.size());
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            REQUIRE(report.errors[i].offset == expected[i].offset);
+            REQUIRE(report.errors[i].line == expected[i].line);
+            REQUIRE(report.errors[i].result.error == expected[i].result.error);
+            REQUIRE(report.errors[i].result.status == expected[i].result.status);
+        }
+    }
+    REQUIRE(Containers::validateBoxes(dump.data(), dump.data() + dump.find(broken[0]) - 1).ok());
+}
+
+TEST_CASE("#JOURNAL: snapshot and journal recover the latest state") {
+    const std::string snapshotPath = "test_journal_snapshot.bin", journalPath = "test_journal.log";
+    std::remove(journalPath.c_str());
+    std::vector<Containers::Box> boxes;
+    for (int i = 0; i < 10; ++i) {
+        boxes.push_back(Containers::Box({i + 2, 5, 5}));
+    }
+    {
+        std::ofstream snapshot(snapshotPath.c_str(), std::ios::binary);
+        Containers::writeBinary(snapshot, boxes.data(), boxes.size());
+    }
+    {
+        Containers::BoxJournal journal(journalPath, Containers::JournalOptions(Containers::SyncPolicy::NONE, 4));
+        for (int i = 0; i < 10; i += 2) {
+            journal.open(boxes[i]);
+            journal.putItem(boxes[i], {1, 1, 1});
+        }
+        journal.close(boxes[0]);
+        REQUIRE(journal.takeItem(boxes[4]) == Containers::Dimensions(1, 1, 1));
+        boxes.push_back(journal.create({7, 7, 7}));
+        journal.open(boxes.back());
+        journal.increment(boxes.back());
+        REQUIRE_THROWS_AS(journal.close(boxes[1]), std::logic_error);
+        journal.commit();
+    }
+    std::vector<Containers::BoxValue> recovered;
+    Containers::BoxJournal::recover(snapshotPath, journalPath, recovered);
+    REQUIRE(recovered.size() == boxes.size());
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        REQUIRE(recovered[i].toBox().equals(boxes[i]));
+    }
+
+    std::ofstream(journalPath.c_str(), std::ios::binary | std::ios::app) << "torn record";
+    recovered.clear();
+    Containers::BoxJournal::recover(snapshotPath, journalPath, recovered);
+    REQUIRE(recovered.size() == boxes.size());
+    REQUIRE(recovered.back().toBox().equals(boxes.back()));
+    std::vector<Containers::BoxValue> missing;
+    REQUIRE_THROWS_AS(Containers::BoxJournal::replay(journalPath, missing), std::logic_error);
+    REQUIRE(missing.empty());
+    std::vector<Containers::BoxValue> taken;
+    {
+        std::ifstream snapshot(snapshotPath.c_str(), std::ios::binary);
+        Containers::readBinary(snapshot, taken);
+    }
+    /* The box incremented by the journal would get the id of this one */
+    taken.push_back(Containers::BoxValue(boxes.back().getId(), {1, 1, 1}));
+    REQUIRE_THROWS_AS(Containers::BoxJournal::replay(journalPath, taken), std::logic_error);
+    REQUIRE(taken.size() == boxes.size());
+    /* A snapshot written by another process may hold the ID the journal created its box with */
+    const std::string reusedPath = "test_journal_reused.log";
+    std::remove(reusedPath.c_str());
+    std::vector<Containers::BoxValue> reused;
+    {
+        Containers::BoxJournal journal(reusedPath);
+        Containers::Box created = journal.create({2, 2, 2});
+        journal.open(created);
+        reused.push_back(Containers::BoxValue(created.getId(), {5, 5, 5}));
+    }
+    try {
+        Containers::BoxJournal::replay(reusedPath, reused);
+        FAIL("a created ID already in the snapshot was replayed");
+    } catch (std::logic_error &e) {
+        REQUIRE(std::string(e.what()).find("Box journal gives a box the id of another box") == 0);
+    }
+    REQUIRE(reused.size() == 1);
+    REQUIRE(reused[0].isClosed());
+    std::remove(reusedPath.c_str());
+
+    const int threads = 4, perThread = 100;
+    {
+        Containers::BoxJournal journal(journalPath);
+        journal.reset();
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.push_back(std::thread([&journal] {
+                for (int i = 0; i < perThread; ++i) {
+                    Containers::Box b = journal.create({3, 3, 3});
+                    journal.open(b);
+                    journal.commit();
+                }
+            }));
+        }
+        for (std::size_t t = 0; t < workers.size(); ++t) {
+            workers[t].join();
+        }
+    }
+    std::vector<Containers::BoxValue> created;
+    REQUIRE(Containers::BoxJournal::replay(journalPath, created) == 2 * threads * perThread);
+    REQUIRE(created.size() == threads * perThread);
+    REQUIRE_FALSE(created.back().isClosed());
+    std::remove(snapshotPath.c_str());
+    std::remove(journalPath.c_str());
+}
+
+TEST_CASE("#JOURNAL: a failed write is cut off and fails the journal") {
+    const std::string journalPath = "test_journal_failed.log";
+    std::remove(journalPath.c_str());
+    Containers::BoxJournal journal(journalPath, Containers::JournalOptions(Containers::SyncPolicy::NONE, 16));
+    Containers::Box b = journal.create({3, 3, 3});
+    journal.commit();
+
+    /* Leave room for half of the next batch, the write of the rest fails with EFBIG instead of a signal */
+    struct rlimit limit, tight;
+    REQUIRE(getrlimit(RLIMIT_FSIZE, &limit) == 0);
+    tight = limit;
+    tight.rlim_cur = 16 + 28 + 40;
+    void (*handler)(int) = std::signal(SIGXFSZ, SIG_IGN);
+    REQUIRE(setrlimit(RLIMIT_FSIZE, &tight) == 0);
+    journal.open(b);
+    journal.putItem(b, {1, 1, 1});
+    journal.close(b);
+    bool thrown = false;
+    try {
+        journal.commit();
+    } catch (std::runtime_error &) {
+        thrown = true;
+    }
+    setrlimit(RLIMIT_FSIZE, &limit);
+    std::signal(SIGXFSZ, handler);
+    REQUIRE(thrown);
+
+    std::ifstream file(journalPath.c_str(), std::ios::binary | std::ios::ate);
+    REQUIRE(file.tellg() == std::streamoff(16 + 28));
+    REQUIRE_THROWS_AS(journal.commit(), std::runtime_error);
+    REQUIRE_THROWS_AS(journal.open(b), std::runtime_error);
+    REQUIRE(b.isClosed());
+    std::vector<Containers::BoxValue> replayed;
+    REQUIRE(Containers::BoxJournal::replay(journalPath, replayed) == 1);
+
+    journal.reset();
+    journal.create({4, 4, 4});
+    journal.commit();
+    replayed.clear();
+    REQUIRE(Containers::BoxJournal::replay(journalPath, replayed) == 1);
+    REQUIRE(replayed[0].getSize() == Containers::Dimensions(4, 4, 4));
+    std::remove(journalPath.c_str());
+}
+
+TEST_CASE("#DELTA: delta snapshots merge into a new base") {
+    std::vector<Containers::Box> boxes;
+    for (int i = 0; i < 10; ++i) {
+        boxes.push_back(Containers::Box({i + 2, 5, 5}));
+    }
+    Containers::Box fresh({3, 3, 3});
+    std::stringstream base;
+    Containers::writeBinary(base, boxes.data(), boxes.size());
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        REQUIRE(boxes[i].isDirty());
+        boxes[i].markClean();
+    }
+
+    boxes[1].open();
+    boxes[1].putItem({1, 1, 1});
+    boxes[3].open();
+    long long renamed = boxes[9].getId();
+    boxes[9]++;
+    ++boxes[9];
+    ++boxes[9];
+    ++boxes[8];
+    REQUIRE(boxes[8].getId() == renamed);
+    REQUIRE(boxes[9].getCheckpointId() == renamed);
+    boxes.push_back(fresh);
+    REQUIRE_FALSE(boxes[0].isDirty());
+    REQUIRE(boxes[1].isDirty());
+
+    std::stringstream delta, empty;
+    REQUIRE(Containers::writeDelta(delta, boxes.data(), boxes.size()) == 5 + 2);
+    REQUIRE_FALSE(boxes[1].isDirty());
+    REQUIRE(boxes[9].getCheckpointId() == boxes[9].getId());
+    boxes[3].close();
+    boxes[4].open();
+    Containers::Box replacement({4, 4, 4});
+    boxes[4] = replacement;
+    REQUIRE(boxes[4].getCheckpointId() != boxes[4].getId());
+    /* The next new ID is the one boxes[9] was incremented to */
+    Containers::Box clash({6, 6, 6}), moved({6, 6, 6});
+    REQUIRE(clash.getId() == boxes[9].getId());
+    boxes[5] = std::move(moved);
+    REQUIRE(boxes[5].isDirty());
+    REQUIRE(boxes[5].getCheckpointId() != boxes[5].getId());
+    REQUIRE(Containers::writeDelta(empty, boxes.data(), boxes.size()) == 5);
+
+    std::vector<Containers::BoxValue> rejected;
+    REQUIRE_THROWS_AS(Containers::readBinary(delta, rejected), std::logic_error);
+    delta.seekg(0);
+    std::stringstream merged;
+    std::vector<std::istream *> deltas = {&delta, &empty};
+    Containers::mergeSnapshots(base, deltas, merged);
+    std::vector<Containers::Box> restored;
+    Containers::readBinary(merged, restored);
+    REQUIRE(restored.size() == boxes.size());
+    REQUIRE_FALSE(restored[0].isDirty());
+    auto byId = [](const Containers::Box &a, const Containers::Box &b) { return a.getId() < b.getId(); };
+    std::sort(restored.begin(), restored.end(), byId);
+    std::sort(boxes.begin(), boxes.end(), byId);
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        REQUIRE(restored[i].equals(boxes[i]));
+    }
+
+    Containers::BoxStore store;
+    for (int i = 0; i < 100; ++i) {
+        store.add({i + 1, 2, 2});
+    }
+    REQUIRE(store.countDirty() == 100);
+    std::stringstream storeBase, storeDelta, storeMerged;
+    Containers::writeDelta(storeBase, store);
+    REQUIRE(store.countDirty() == 0);
+    store.open(7);
+    store.putItem(7, {1, 1, 1});
+    store.add({5, 5, 5});
+    REQUIRE(Containers::writeDelta(storeDelta, store) == 2);
+    std::vector<Containers::BoxValue> values;
+    std::stringstream plainBase;
+    Containers::writeBinary(plainBase, values.data(), values.size());
+    deltas = {&storeBase, &storeDelta};
+    Containers::mergeSnapshots(plainBase, deltas, storeMerged);
+    Containers::readBinary(storeMerged, values);
+    REQUIRE(values.size() == store.size());
+    REQUIRE(values[7].isFull());
+    REQUIRE(values.back().getSize() == Containers::Dimensions(5, 5, 5));
+
+    plainBase.seekg(0);
+    storeDelta.seekg(0);
+    std::stringstream swapped;
+    deltas = {&plainBase};
+    REQUIRE_THROWS_AS(Containers::mergeSnapshots(storeDelta, deltas, swapped), std::logic_error);
+    storeMerged.seekg(0);
+    REQUIRE_THROWS_AS(Containers::mergeSnapshots(storeMerged, deltas, swapped), std::logic_error);
+    REQUIRE(swapped.str().empty());
+}
+
+TEST_CASE("#VOLUME: volume index matches a linear scan") {
+    std::vector<Containers::BoxValue> boxes;
+    Containers::VolumeIndex index;
+    for (int i = 0; i < 3000; ++i) {
+        boxes.push_back(Containers::BoxValue({i % 17 + 1, i % 13 + 1, i % 7 + 1}));
+        REQUIRE(index.insert(boxes.back()));
+    }
+    REQUIRE_FALSE(index.insert(boxes[0]));
+    REQUIRE(index.size() == boxes.size());
+
+    std::vector<bool> present(boxes.size(), true);
+    unsigned state = 12345;
+    for (int step = 0; step < 6000; ++step) {
+        state = state * 1103515245 + 12345;
+        std::size_t i = (state >> 8) % boxes.size();
+        if (!present[i]) {
+            REQUIRE(index.insert(boxes[i]));
+            present[i] = true;
+        } else if (step % 5 == 0) {
+            REQUIRE(index.erase(boxes[i].getId()));
+            REQUIRE_FALSE(index.contains(boxes[i].getId()));
+            present[i] = false;
+        } else if (boxes[i].isFull()) {
+            boxes[i].open();
+            boxes[i].takeItem();
+            boxes[i].close();
+            REQUIRE(index.update(boxes[i]));
+        } else {
+            boxes[i].open();
+            boxes[i].putItem({1, 1, 1});
+            boxes[i].close();
+            REQUIRE(index.update(boxes[i]));
+        }
+    }
+    REQUIRE_FALSE(index.update(-1, {1, 1, 1}, true));
+
+    for (int emptyOnly = 0; emptyOnly < 2; ++emptyOnly) {
+        std::vector<std::pair<long long, long long> > expected;
+        for (std::size_t i = 0; i < boxes.size(); ++i) {
+            if (present[i] && !(emptyOnly && boxes[i].isFull())) {
+                expected.push_back(std::make_pair((long long)boxes[i].getSize().computeVolume(), boxes[i].getId()));
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+        for (long long low = 0; low < 2000; low += 97) {
+            long long high = low + 300;
+            std::vector<long long> ids;
+            index.findInRange(low, high, ids, emptyOnly);
+            std::vector<long long> scanned;
+            std::size_t below = 0;
+            for (std::size_t i = 0; i < expected.size(); ++i) {
+                below += expected[i].first < low;
+                if (expected[i].first >= low && expected[i].first <= high) {
+                    scanned.push_back(expected[i].second);
+                }
+            }
+            REQUIRE(ids == scanned);
+            REQUIRE(index.countInRange(low, high, emptyOnly) == scanned.size());
+            REQUIRE(index.rank(low, emptyOnly) == below);
+        }
+        std::vector<long long> top;
+        index.topK(25, top, emptyOnly);
+        REQUIRE(top.size() == 25);
+        for (std::size_t i = 0; i < top.size(); ++i) {
+            REQUIRE(top[i] == expected[expected.size() - 1 - i].second);
+        }
+    }
+    REQUIRE(index.countInRange(10, 5) == 0);
+    index.clear();
+    REQUIRE(index.size() == 0);
+    REQUIRE(index.rank(1000) == 0);
+}
+
+TEST_CASE("#FIT: smallest fitting box matches a linear scan") {
+    std::vector<Containers::BoxValue> boxes;
+    std::vector<bool> present;
+    Containers::FitIndex index;
+    unsigned state = 777;
+    auto next = [&state](int range) {
+        state = state * 1103515245 + 12345;
+        return (int)((state >> 8) % range) + 1;
+    };
+    for (int i = 0; i < 5000; ++i) {
+        boxes.push_back(Containers::BoxValue({next(40), next(40), next(40)}));
+        present.push_back(true);
+        REQUIRE(index.insert(boxes.back()));
+    }
+    REQUIRE_FALSE(index.insert(boxes[0]));
+    Containers::BoxValue full({5, 5, 5});
+    full.open();
+    full.putItem({1, 1, 1});
+    REQUIRE_FALSE(index.insert(full));
+    REQUIRE_THROWS_AS(index.insert(-1, {0, 1, 1}), std::invalid_argument);
+
+    for (int step = 0; step < 3000; ++step) {
+        Containers::Dimensions item(next(35), next(35), next(35));
+        long long bestVolume = -1;
+        for (std::size_t i = 0; i < boxes.size(); ++i) {
+            Containers::BoxValue probe = boxes[i];
+            probe.tryOpen();
+            long long volume = probe.getSize().computeVolume();
+            if (present[i] && probe.tryPutItem(item) == Containers::BoxStatus::OK && probe.tryClose() == Containers::BoxStatus::OK &&
+                (bestVolume < 0 || volume < bestVolume)) {
+                bestVolume = volume;
+            }
+        }
+        long long id;
+        Containers::Dimensions size;
+        REQUIRE(index.findSmallest(item, id, size) == (bestVolume >= 0));
+        if (bestVolume < 0) {
+            continue;
+        }
+        REQUIRE(size.computeVolume() == bestVolume);
+        std::size_t chosen = 0;
+        while (boxes[chosen].getId() != id) {
+            ++chosen;
+        }
+        REQUIRE(boxes[chosen].getSize() == size);
+        if (step % 3 != 0) {
+            REQUIRE(index.erase(id));
+            present[chosen] = false;
+        }
+        if (step % 4 == 0) {
+            std::size_t i = next(boxes.size()) - 1;
+            if (!present[i]) {
+                REQUIRE(index.insert(boxes[i]));
+                present[i] = true;
+            }
+        }
+    }
+    REQUIRE(index.size() == (std::size_t)std::count(present.begin(), present.end(), true));
+    REQUIRE_FALSE(index.erase(-1));
+    index.clear();
+    long long id;
+    REQUIRE_FALSE(index.findSmallest({1, 1, 1}, id));
+}
+
+static void bestMatching(const std::vector<Containers::Dimensions> &items, const std::vector<Containers::BoxValue> &boxes, std::size_t item,
+                         std::vector<bool> &used, std::size_t matched, long long waste, std::size_t &bestMatched, long long &bestWaste) {
+    if (item == items.size()) {
+        if (matched > bestMatched || (matched == bestMatched && waste < bestWaste)) {
+            bestMatched = matched;
+            bestWaste = waste;
+        }
+        return;
+    }
+    bestMatching(items, boxes, item + 1, used, matched, waste, bestMatched, bestWaste);
+    for (std::size_t b = 0; b < boxes.size(); ++b) {
+        Containers::BoxValue probe = boxes[b];
+        probe.tryOpen();
+        if (!used[b] && probe.tryPutItem(items[item]) == Containers::BoxStatus::OK && probe.tryClose() == Containers::BoxStatus::OK) {
+            used[b] = true;
+            bestMatching(items, boxes, item + 1, used, matched + 1, waste + probe.getSize().computeVolume() - items[item].computeVolume(), bestMatched,
+                         bestWaste);
+            used[b] = false;
+        }
+    }
+}
+
+TEST_CASE("#ASSIGN: greedy and optimal item assignment") {
+    unsigned state = 99;
+    auto next = [&state](int range) {
+        state = state * 1103515245 + 12345;
+        return (int)((state >> 8) % range) + 1;
+    };
+    for (int trial = 0; trial < 20; ++trial) {
+        std::vector<Containers::Dimensions> items;
+        std::vector<Containers::BoxValue> boxes;
+        for (int i = 0; i < 4 + trial % 4; ++i) {
+            items.push_back(Containers::Dimensions(next(9), next(9), next(9)));
+        }
+        for (int b = 0; b < 7 - trial % 5; ++b) {
+            boxes.push_back(Containers::BoxValue({next(10), next(10), next(10)}));
+        }
+        std::vector<bool> used(boxes.size(), false);
+        std::size_t bestMatched = 0;
+        long long bestWaste = 0;
+        bestMatching(items, boxes, 0, used, 0, 0, bestMatched, bestWaste);
+
+        Containers::Assignment optimal = Containers::assignItems(items.data(), items.size(), boxes.data(), boxes.size(), {Containers::AssignMode::OPTIMAL});
+        REQUIRE(optimal.matched == bestMatched);
+        REQUIRE(optimal.wastedVolume == bestWaste);
+        Containers::Assignment greedy = Containers::assignItems(items.data(), items.size(), boxes.data(), boxes.size());
+        REQUIRE(greedy.matched <= bestMatched);
+        std::vector<Containers::BoxValue> filled = boxes;
+        Containers::applyAssignment(optimal, items.data(), filled.data());
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            if (optimal.boxOf[i] != Containers::Assignment::NONE) {
+                REQUIRE(filled[optimal.boxOf[i]].getItem() == items[i]);
+                REQUIRE(filled[optimal.boxOf[i]].isClosed());
+            }
+        }
+        std::size_t last = items.size();
+        while (last != 0 && optimal.boxOf[last - 1] == Containers::Assignment::NONE) {
+            --last;
+        }
+        if (last != 0) {
+            /* Only the box of the last matched item changed, none of the boxes before it may be filled either */
+            std::vector<Containers::BoxValue> stale = boxes;
+            stale[optimal.boxOf[last - 1]].open();
+            stale[optimal.boxOf[last - 1]].putItem({1, 1, 1});
+            REQUIRE_THROWS_AS(Containers::applyAssignment(optimal, items.data(), stale.data()), std::logic_error);
+            for (std::size_t i = 0; i + 1 < last; ++i) {
+                if (optimal.boxOf[i] != Containers::Assignment::NONE) {
+                    REQUIRE_FALSE(stale[optimal.boxOf[i]].isFull());
+                }
+            }
+            std::vector<Containers::Dimensions> flat = items;
+            flat[last - 1] = Containers::Dimensions(0, 1, 1);
+            stale = boxes;
+            REQUIRE_THROWS_AS(Containers::applyAssignment(optimal, flat.data(), stale.data()), std::invalid_argument);
+            for (std::size_t b = 0; b < stale.size(); ++b) {
+                REQUIRE_FALSE(stale[b].isFull());
+            }
+        }
+    }
+
+    std::vector<Containers::Dimensions> items;
+    std::vector<Containers::Box> boxes;
+    for (int i = 0; i < 20000; ++i) {
+        items.push_back(Containers::Dimensions(next(50), next(50), next(50)));
+        boxes.push_back(Containers::Box({next(60), next(60), next(60)}));
+    }
+    items[0] = Containers::Dimensions(0, 1, 1);
+    boxes[0].open();
+    boxes[0].putItem({1, 1, 1});
+    for (unsigned threads = 1; threads <= 4; threads *= 2) {
+        Containers::Assignment a = Containers::assignItems(items.data(), items.size(), boxes.data(), boxes.size(), {Containers::AssignMode::GREEDY, threads});
+        REQUIRE(a.boxOf[0] == Containers::Assignment::NONE);
+        REQUIRE(a.matched > items.size() / 4);
+        std::vector<bool> used(boxes.size(), false);
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            if (a.boxOf[i] != Containers::Assignment::NONE) {
+                REQUIRE_FALSE(used[a.boxOf[i]]);
+                used[a.boxOf[i]] = true;
+            }
+        }
+        std::vector<Containers::Box> filled = boxes;
+        Containers::applyAssignment(a, items.data(), filled.data());
+        REQUIRE((std::size_t)std::count_if(filled.begin(), filled.end(), [](const Containers::Box &b) { return b.isFull(); }) == a.matched + 1);
+    }
+}
+
+TEST_CASE("#CONTAINER: multi-item packing without overlaps") {
+    Containers::Container cube({10, 10, 10});
+    std::vector<Containers::Dimensions> cubes(8, Containers::Dimensions(5, 5, 5));
+    REQUIRE(cube.insert(cubes.data(), cubes.size()) == 8);
+    REQUIRE(cube.getFillRatio() == 1.0);
+    REQUIRE_FALSE(cube.insert({1, 1, 1}));
+    REQUIRE_THROWS_AS(cube.insert({1, 0, 1}), std::invalid_argument);
+    REQUIRE_THROWS_AS(Containers::Container({0, 1, 1}), std::invalid_argument);
+    cube.clear();
+    REQUIRE(cube.getItemCount() == 0);
+    REQUIRE(cube.insert({10, 10, 10}));
+
+    Containers::Container flat({2, 2, 10});
+    REQUIRE_FALSE(flat.insert({10, 2, 2}));
+    REQUIRE(flat.insert({10, 2, 2}, true));
+    REQUIRE(flat.getPlacements()[0].item == Containers::Dimensions(2, 2, 10));
+
+    Containers::Container pallet({120, 80, 100});
+    std::vector<Containers::Dimensions> items;
+    unsigned state = 3;
+    for (int i = 0; i < 400; ++i) {
+        state = state * 1103515245 + 12345;
+        items.push_back(Containers::Dimensions((state >> 8) % 30 + 5, (state >> 13) % 25 + 5, (state >> 18) % 20 + 5));
+    }
+    std::vector<bool> placed;
+    std::size_t count = pallet.insert(items.data(), items.size(), placed, true);
+    REQUIRE(count == pallet.getItemCount());
+    REQUIRE((std::size_t)std::count(placed.begin(), placed.end(), true) == count);
+    REQUIRE(pallet.getFillRatio() > 0.5);
+    const std::vector<Containers::Placement> &p = pallet.getPlacements();
+    long long volume = 0;
+    for (std::size_t i = 0; i < p.size(); ++i) {
+        const Containers::Dimensions &a = p[i].item;
+        volume += a.computeVolume();
+        REQUIRE(p[i].x >= 0);
+        REQUIRE(p[i].y >= 0);
+        REQUIRE(p[i].z >= 0);
+        REQUIRE(p[i].x + a.getLength() <= 120);
+        REQUIRE(p[i].y + a.getWidth() <= 80);
+        REQUIRE(p[i].z + a.getHeight() <= 100);
+        for (std::size_t j = 0; j < i; ++j) {
+            const Containers::Dimensions &b = p[j].item;
+            bool apart = p[i].x + a.getLength() <= p[j].x || p[j].x + b.getLength() <= p[i].x || p[i].y + a.getWidth() <= p[j].y ||
+                         p[j].y + b.getWidth() <= p[i].y || p[i].z + a.getHeight() <= p[j].z || p[j].z + b.getHeight() <= p[i].z;
+            REQUIRE(apart);
+        }
+    }
+    REQUIRE(volume == pallet.getUsedVolume());
+}
+
+TEST_CASE("#BATCHFIT: batch fit kernel matches putItem and close") {
+    unsigned state = 41;
+    auto next = [&state](int range) {
+        state = state * 1103515245 + 12345;
+        return (int)((state >> 8) % range) + 1;
+    };
+    Containers::SizeCatalog catalog;
+    std::vector<Containers::BoxValue> boxes;
+    for (int b = 0; b < 203; ++b) {
+        boxes.push_back(Containers::BoxValue({next(20), next(20), next(20)}));
+        catalog.add(boxes.back());
+    }
+    REQUIRE(catalog.size() == boxes.size());
+    REQUIRE(catalog.get(7) == boxes[7].getSize());
+    REQUIRE(catalog.rowWords() == 4);
+    REQUIRE_THROWS_AS(catalog.add(Containers::Dimensions(1, -1, 1)), std::invalid_argument);
+    std::vector<Containers::Dimensions> items;
+    for (int i = 0; i < 300; ++i) {
+        items.push_back(Containers::Dimensions(next(20), next(20), next(20)));
+    }
+    items[5] = Containers::Dimensions(0, 1, 1);
+
+    const Containers::ScanLevel levels[] = {Containers::ScanLevel::SCALAR, Containers::ScanLevel::SSE2, Containers::ScanLevel::AVX2};
+    for (int rotate = 0; rotate < 2; ++rotate) {
+        for (Containers::ScanLevel level : levels) {
+            std::vector<std::uint64_t> bits;
+            Containers::fitItems(items.data(), items.size(), catalog, bits, rotate, level);
+            REQUIRE(bits.size() == items.size() * catalog.rowWords());
+            for (std::size_t i = 0; i < items.size(); ++i) {
+                int d[3] = {items[i].getLength(), items[i].getWidth(), items[i].getHeight()};
+                std::sort(d, d + 3);
+                for (std::size_t b = 0; b < boxes.size(); ++b) {
+                    bool expected = false;
+                    do {
+                        Containers::BoxValue probe = boxes[b];
+                        probe.open();
+                        expected = expected || (probe.tryPutItem({d[0], d[1], d[2]}) == Containers::BoxStatus::OK &&
+                                                probe.tryClose() == Containers::BoxStatus::OK && (rotate || Containers::Dimensions(d[0], d[1], d[2]) == items[i]));
+                    } while (std::next_permutation(d, d + 3));
+                    REQUIRE(Containers::testFit(bits, catalog.rowWords(), i, b) == expected);
+                }
+            }
+        }
+    }
+    catalog.clear();
+    std::vector<std::uint64_t> bits;
+    Containers::fitItems(items.data(), items.size(), catalog, bits);
+    REQUIRE(bits.empty());
+}
 
 TEST_CASE("#CUSTOM: general box functionality") {
     Containers::Box b;